@@ -0,0 +1,155 @@
+#include "AccessPolicy.h"
+#include "TimeFormat.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const int SLOTS_PER_DAY = 24 * 60 / AccessPolicy::SLOT_MINUTES;
+const char* DAY_NAMES[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+int parseDay(const string& text) {
+    for (int d = 0; d < 7; ++d) {
+        if (text == DAY_NAMES[d]) return d;
+    }
+    return -1;
+}
+
+// Fills days[0..6] from "*", "mon", "mon-fri" or a comma list of those.
+bool parseDays(const string& text, bool days[7]) {
+    for (int d = 0; d < 7; ++d) days[d] = false;
+
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (item == "*") {
+            for (int d = 0; d < 7; ++d) days[d] = true;
+            continue;
+        }
+        size_t dash = item.find('-');
+        int first = parseDay(item.substr(0, dash));
+        int last = dash == string::npos ? first : parseDay(item.substr(dash + 1));
+        if (first < 0 || last < 0) {
+            return false;
+        }
+        for (int d = first; ; d = (d + 1) % 7) {
+            days[d] = true;
+            if (d == last) break;
+        }
+    }
+    return true;
+}
+
+// "HH:MM" to minutes since midnight; 24:00 is accepted as end of day.
+bool parseTime(const string& text, int& minutes) {
+    int hours, mins;
+    char colon;
+    stringstream ss(text);
+    if (!(ss >> hours >> colon >> mins) || colon != ':' || !ss.eof()) {
+        return false;
+    }
+    if (hours < 0 || hours > 24 || mins < 0 || mins > 59 || (hours == 24 && mins != 0)) {
+        return false;
+    }
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+}
+
+AccessPolicy::AccessPolicy() {
+    allowAll();
+}
+
+void AccessPolicy::allowAll() {
+    memset(table, 0xff, sizeof(table));
+    ruleCount = 0;
+}
+
+void AccessPolicy::denyAll() {
+    memset(table, 0, sizeof(table));
+    ruleCount = 0;
+}
+
+bool AccessPolicy::loadFromFile(const string& path, string& error) {
+    ifstream file(path);
+    if (!file) {
+        allowAll();
+        return true;
+    }
+
+    uint64_t compiled[static_cast<int>(UserRole::COUNT)][WORDS_PER_ROLE];
+    bool hasRule[static_cast<int>(UserRole::COUNT)] = {false};
+    memset(compiled, 0xff, sizeof(compiled));
+    size_t rules = 0;
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.erase(comment);
+        }
+
+        stringstream ss(line);
+        string roleText, daysText, fromText, toText, extra;
+        if (!(ss >> roleText)) {
+            continue; // blank line
+        }
+        string where = "line " + to_string(lineNumber) + ": ";
+        if (!(ss >> daysText >> fromText >> toText) || (ss >> extra)) {
+            error = where + "expected '<role> <days> <from> <to>'";
+            return false;
+        }
+
+        UserRole role;
+        bool days[7];
+        int from, to;
+        if (!parseUserRole(roleText, role)) {
+            error = where + "unknown role '" + roleText + "'";
+            return false;
+        }
+        if (!parseDays(daysText, days)) {
+            error = where + "bad day list '" + daysText + "'";
+            return false;
+        }
+        if (!parseTime(fromText, from) || from == 24 * 60 || !parseTime(toText, to)) {
+            error = where + "bad time window '" + fromText + " " + toText + "'";
+            return false;
+        }
+
+        int r = static_cast<int>(role);
+        if (!hasRule[r]) {
+            memset(compiled[r], 0, sizeof(compiled[r]));
+            hasRule[r] = true;
+        }
+
+        // round inwards so a partial slot never admits outside the window
+        int firstSlot = (from + SLOT_MINUTES - 1) / SLOT_MINUTES;
+        int lastSlot = to / SLOT_MINUTES;
+        if (to <= from) {
+            lastSlot += SLOTS_PER_DAY; // wraps past midnight
+        }
+
+        for (int d = 0; d < 7; ++d) {
+            if (!days[d]) continue;
+            for (int s = firstSlot; s < lastSlot; ++s) {
+                int slot = (d * SLOTS_PER_DAY + s) % SLOTS_PER_WEEK;
+                compiled[r][slot >> 6] |= uint64_t(1) << (slot & 63);
+            }
+        }
+        ++rules;
+    }
+
+    memcpy(table, compiled, sizeof(table));
+    ruleCount = rules;
+    return true;
+}
+
+bool AccessPolicy::allows(UserRole role, time_t when) const {
+    return allowsSlot(role, localMinuteOfWeek(when) / SLOT_MINUTES);
+}
@@ -0,0 +1,50 @@
+#ifndef ACCESSPOLICY_H
+#define ACCESSPOLICY_H
+
+#include "User.h"
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// Role and time-of-day admission rules compiled into a bit table with one
+// bit per (role, 15-minute slot of the week). A decision is a table lookup;
+// the rule text is only looked at when the policy is loaded.
+//
+// Config format, one rule per line ('#' starts a comment):
+//     <role> <days> <from> <to>
+//     student  *        08:00  22:00
+//     staff    mon-fri  06:00  23:00
+//     faculty  *        00:00  24:00
+// days is '*', a day ('mon'), a range ('mon-fri') or a comma list of those.
+// A window with from > to runs past midnight into the next day. Once a role
+// has a rule it is admitted only inside its windows; roles without rules
+// are admitted at any time.
+class AccessPolicy {
+public:
+    static const int SLOT_MINUTES = 15;
+    static const int SLOTS_PER_WEEK = 7 * 24 * 60 / SLOT_MINUTES;
+    static const int WORDS_PER_ROLE = (SLOTS_PER_WEEK + 63) / 64;
+
+    AccessPolicy();
+
+    // Replaces the table only if the whole file compiles; a missing file
+    // leaves every role admitted. On failure error names the bad line and
+    // the table is left as it was.
+    bool loadFromFile(const std::string& path, std::string& error);
+    void allowAll();
+    void denyAll();
+
+    bool allows(UserRole role, std::time_t when) const;
+    bool allowsSlot(UserRole role, int slot) const {
+        const uint64_t* row = table[static_cast<int>(role)];
+        return (row[slot >> 6] >> (slot & 63)) & 1;
+    }
+
+    size_t getRuleCount() const { return ruleCount; }
+
+private:
+    uint64_t table[static_cast<int>(UserRole::COUNT)][WORDS_PER_ROLE];
+    size_t ruleCount;
+};
+
+#endif
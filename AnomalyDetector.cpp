@@ -0,0 +1,154 @@
+#include "AnomalyDetector.h"
+#include "Metrics.h"
+#include "TimeFormat.h"
+
+using namespace std;
+
+namespace {
+
+const char* KIND_EVENTS[] = {"door_hop", "double_in", "night_access", "scan_burst"};
+
+const int MINUTES_PER_DAY = 24 * 60;
+
+}
+
+AnomalyDetector::AnomalyDetector(const string& alertPath, const AnomalyRules& anomalyRules)
+    : rules(anomalyRules), alertCounts() {
+    if (!alertLog.start(alertPath)) {
+        Logger::instance().log(LogLevel::ERROR, "alert_log_error", "Cannot open alert log " + alertPath);
+    }
+}
+
+void AnomalyDetector::setDoorName(uint16_t door, const string& name) {
+    lock_guard<mutex> lock(detectorMutex);
+    if (door >= doorNames.size()) {
+        doorNames.resize(door + 1);
+    }
+    doorNames[door] = name;
+}
+
+uint32_t AnomalyDetector::ordinalLocked(StringRef userId) {
+    thread_local string key; // reused so a lookup does not allocate
+    key.assign(userId.data, userId.length);
+    auto it = ordinals.find(key);
+    if (it != ordinals.end()) {
+        return it->second;
+    }
+    uint32_t ordinal = static_cast<uint32_t>(windows.size());
+    it = ordinals.insert(make_pair(key, ordinal)).first;
+    cardIds.push_back(&it->first);
+    windows.push_back(CardWindow());
+    return ordinal;
+}
+
+uint32_t AnomalyDetector::ordinalOf(StringRef userId) {
+    lock_guard<mutex> lock(detectorMutex);
+    return ordinalLocked(userId);
+}
+
+unsigned AnomalyDetector::observe(StringRef userId, uint16_t door, bool in, time_t when) {
+    lock_guard<mutex> lock(detectorMutex);
+    return observeLocked(ordinalLocked(userId), door, in, when);
+}
+
+unsigned AnomalyDetector::observe(uint32_t ordinal, uint16_t door, bool in, time_t when) {
+    lock_guard<mutex> lock(detectorMutex);
+    if (ordinal >= windows.size()) {
+        return 0; // not handed out by ordinalOf
+    }
+    return observeLocked(ordinal, door, in, when);
+}
+
+unsigned AnomalyDetector::observeLocked(uint32_t ordinal, uint16_t door, bool in, time_t when) {
+    CardWindow& card = windows[ordinal];
+    uint32_t now = static_cast<uint32_t>(when);
+    unsigned raised = 0;
+
+    if (in) {
+        int64_t sinceIn = static_cast<int64_t>(now) - card.lastIn;
+        if (card.lastIn != 0 && card.lastInDoor != door && sinceIn >= 0 && sinceIn <= rules.doorHopSeconds) {
+            raise(AnomalyKind::DOOR_HOP, ordinal, door, when,
+                  to_string(sinceIn) + " s after IN at " + doorName(card.lastInDoor));
+            ++raised;
+        }
+        if (card.insideDoor != NO_DOOR && card.insideDoor != door) {
+            raise(AnomalyKind::DOUBLE_IN, ordinal, door, when, "still IN at " + doorName(card.insideDoor));
+            ++raised;
+        }
+        if (isNight(when)) {
+            raise(AnomalyKind::NIGHT_ACCESS, ordinal, door, when, "IN at night");
+            ++raised;
+        }
+        card.lastIn = now;
+        card.lastInDoor = door;
+        card.insideDoor = door;
+    } else if (card.insideDoor == door) {
+        card.insideDoor = NO_DOOR;
+    }
+
+    // the slot about to be overwritten holds the scan BURST_SCANS - 1 back;
+    // one alert per burst, until a whole new window has passed
+    uint32_t oldest = card.recent[card.next];
+    int64_t window = static_cast<int64_t>(now) - oldest;
+    if (oldest != 0 && window >= 0 && window <= rules.burstSeconds && card.lastBurstAlert < oldest) {
+        raise(AnomalyKind::SCAN_BURST, ordinal, door, when,
+              to_string(BURST_SCANS) + " scans in " + to_string(window) + " s");
+        card.lastBurstAlert = now;
+        ++raised;
+    }
+    card.recent[card.next] = now;
+    card.next = static_cast<uint8_t>((card.next + 1) % (BURST_SCANS - 1));
+    return raised;
+}
+
+void AnomalyDetector::markInside(StringRef userId, uint16_t door) {
+    lock_guard<mutex> lock(detectorMutex);
+    windows[ordinalLocked(userId)].insideDoor = door;
+}
+
+void AnomalyDetector::resetDoor(uint16_t door) {
+    lock_guard<mutex> lock(detectorMutex);
+    for (auto& card : windows) {
+        if (card.insideDoor == door) {
+            card.insideDoor = NO_DOOR;
+        }
+    }
+}
+
+bool AnomalyDetector::isNight(time_t when) const {
+    if (rules.nightStartMinute == rules.nightEndMinute) {
+        return false;
+    }
+    int minute = localMinuteOfWeek(when) % MINUTES_PER_DAY;
+    if (rules.nightStartMinute < rules.nightEndMinute) {
+        return minute >= rules.nightStartMinute && minute < rules.nightEndMinute;
+    }
+    return minute >= rules.nightStartMinute || minute < rules.nightEndMinute;
+}
+
+string AnomalyDetector::doorName(uint16_t door) const {
+    if (door < doorNames.size() && !doorNames[door].empty()) {
+        return doorNames[door];
+    }
+    return "door " + to_string(door);
+}
+
+void AnomalyDetector::raise(AnomalyKind kind, uint32_t ordinal, uint16_t door, time_t when, const string& detail) {
+    ++alertCounts[static_cast<int>(kind)];
+    Metrics::instance().increment(MetricCounter::ALERTS);
+    const string& userId = *cardIds[ordinal];
+    string place = doorName(door);
+    alertLog.log(LogLevel::WARN, KIND_EVENTS[static_cast<int>(kind)],
+                 "ALERT: " + userId + " at " + place + " " + formatTimestamp(when) + " - " + detail,
+                 {{"user_id", userId}, {"door", place}, {"unix_timestamp", to_string(when)}});
+}
+
+uint64_t AnomalyDetector::getAlertCount(AnomalyKind kind) const {
+    lock_guard<mutex> lock(detectorMutex);
+    return alertCounts[static_cast<int>(kind)];
+}
+
+size_t AnomalyDetector::getCardCount() const {
+    lock_guard<mutex> lock(detectorMutex);
+    return windows.size();
+}
@@ -0,0 +1,98 @@
+#ifndef ANOMALYDETECTOR_H
+#define ANOMALYDETECTOR_H
+
+#include "Arena.h"
+#include "Logger.h"
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AnomalyKind : uint8_t {
+    DOOR_HOP,     // IN at another door shortly after an IN (cloned card)
+    DOUBLE_IN,    // IN while still IN at another door (replayed or cloned card)
+    NIGHT_ACCESS, // IN inside the night window
+    SCAN_BURST,   // BURST_SCANS scans of one card in a short window (tailgating)
+    COUNT
+};
+
+struct AnomalyRules {
+    int64_t doorHopSeconds = 30;
+    int nightStartMinute = 22 * 60; // local time; start > end wraps past midnight,
+    int nightEndMinute = 6 * 60;    // start == end disables the rule
+    int64_t burstSeconds = 60;
+};
+
+// Streaming checks on every accepted scan. Each card has a fixed-size
+// window (its last few scan times, its last IN and the door it is inside)
+// in an array indexed by card ordinal, so a scan costs one lookup and a few
+// comparisons however long the history is. Alerts go to their own log, one
+// JSON object per line.
+//
+// A door is whatever feeds the detector: a standalone RFIDSystem is one
+// door, and a LabCoordinator shares one detector between its labs with a
+// door per lab, which is what makes door hops and double INs visible.
+class AnomalyDetector {
+public:
+    static const size_t BURST_SCANS = 5;
+    static const uint16_t NO_DOOR = 0xFFFF;
+
+    explicit AnomalyDetector(const std::string& alertPath, const AnomalyRules& rules = AnomalyRules());
+    AnomalyDetector(const AnomalyDetector&) = delete;
+    AnomalyDetector& operator=(const AnomalyDetector&) = delete;
+
+    // Used in alert messages instead of "door N".
+    void setDoorName(uint16_t door, const std::string& name);
+
+    // Assigned in order of first sight and stable for the detector's lifetime.
+    uint32_t ordinalOf(StringRef userId);
+
+    // Checks one accepted scan against every rule; returns the number of
+    // alerts raised. Scans of one card must arrive in time order.
+    unsigned observe(StringRef userId, uint16_t door, bool in, std::time_t when);
+    unsigned observe(uint32_t ordinal, uint16_t door, bool in, std::time_t when);
+
+    // Records that the card is IN at door without checking it, e.g. the
+    // stored status at startup.
+    void markInside(StringRef userId, uint16_t door);
+    // Forgets which cards are inside door, after its status was cleared or
+    // reloaded.
+    void resetDoor(uint16_t door);
+
+    uint64_t getAlertCount(AnomalyKind kind) const;
+    size_t getCardCount() const;
+    uint64_t getDroppedAlerts() const { return alertLog.getDroppedCount(); }
+    void flush() { alertLog.flush(); }
+
+private:
+    struct CardWindow {
+        uint32_t recent[BURST_SCANS - 1]; // ring of the latest scan times
+        uint32_t lastIn;
+        uint32_t lastBurstAlert;
+        uint16_t lastInDoor;
+        uint16_t insideDoor;
+        uint8_t next; // ring slot of the oldest scan time
+
+        CardWindow() : recent(), lastIn(0), lastBurstAlert(0), lastInDoor(NO_DOOR), insideDoor(NO_DOOR), next(0) {}
+    };
+
+    AnomalyRules rules;
+    Logger alertLog;
+    mutable std::mutex detectorMutex;
+    std::unordered_map<std::string, uint32_t> ordinals;
+    std::vector<const std::string*> cardIds; // keys of ordinals, by ordinal
+    std::vector<CardWindow> windows;
+    std::vector<std::string> doorNames;
+    uint64_t alertCounts[static_cast<int>(AnomalyKind::COUNT)];
+
+    uint32_t ordinalLocked(StringRef userId);
+    unsigned observeLocked(uint32_t ordinal, uint16_t door, bool in, std::time_t when);
+    bool isNight(std::time_t when) const;
+    std::string doorName(uint16_t door) const;
+    void raise(AnomalyKind kind, uint32_t ordinal, uint16_t door, std::time_t when, const std::string& detail);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "Arena.h"
+#include <algorithm>
+
+using namespace std;
+
+Arena::Arena(size_t size)
+    : cursor(nullptr), limit(nullptr), blockSize(size), bytesUsed(0), bytesReserved(0) {}
+
+void Arena::addBlock(size_t bytes) {
+    blocks.push_back(unique_ptr<char[]>(new char[bytes]));
+    cursor = blocks.back().get();
+    limit = cursor + bytes;
+    bytesReserved += bytes;
+}
+
+void Arena::reserve(size_t bytes) {
+    if (static_cast<size_t>(limit - cursor) < bytes) {
+        addBlock(max(bytes, blockSize));
+    }
+}
+
+char* Arena::allocate(size_t bytes) {
+    reserve(bytes);
+    char* result = cursor;
+    cursor += bytes;
+    bytesUsed += bytes;
+    return result;
+}
+
+StringPool::StringPool(bool internStrings) : interned(internStrings), copies(0) {}
+
+size_t StringPool::Hash::operator()(const StringRef& text) const {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < text.length; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(text.data[i])) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+const char* StringPool::intern(StringRef text) {
+    if (text.length == 0) {
+        return "";
+    }
+    lock_guard<mutex> lock(poolMutex);
+    if (interned) {
+        auto it = entries.find(text);
+        if (it != entries.end()) {
+            return it->data;
+        }
+    }
+    char* copy = arena.allocate(text.length);
+    memcpy(copy, text.data, text.length);
+    if (interned) {
+        entries.insert(StringRef(copy, text.length));
+    } else {
+        ++copies;
+    }
+    return copy;
+}
+
+void StringPool::reserve(size_t bytes) {
+    lock_guard<mutex> lock(poolMutex);
+    arena.reserve(bytes);
+}
+
+size_t StringPool::getEntryCount() const {
+    lock_guard<mutex> lock(poolMutex);
+    return interned ? entries.size() : copies;
+}
+
+size_t StringPool::getBytesUsed() const {
+    lock_guard<mutex> lock(poolMutex);
+    return arena.getBytesUsed();
+}
@@ -0,0 +1,93 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Non-owning view of characters held by an Arena (or a string literal).
+struct StringRef {
+    const char* data;
+    size_t length;
+
+    StringRef() : data(""), length(0) {}
+    StringRef(const char* text, size_t size) : data(text), length(size) {}
+    StringRef(const std::string& text) : data(text.data()), length(text.size()) {}
+
+    std::string str() const { return std::string(data, length); }
+
+    bool operator==(const std::string& other) const {
+        return length == other.length() && std::memcmp(data, other.data(), length) == 0;
+    }
+    bool operator!=(const std::string& other) const { return !(*this == other); }
+};
+
+// Monotonic allocator for string bytes. Allocation bumps a cursor through
+// large blocks and nothing is freed until the arena itself goes away, so
+// thousands of short strings cost a few mallocs. Bytes already handed out
+// never move, which lets readers keep pointers while the writer appends.
+class Arena {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Makes sure the next `bytes` bytes come from a single block.
+    void reserve(size_t bytes);
+    char* allocate(size_t bytes);
+
+    size_t getBytesUsed() const { return bytesUsed; }
+    size_t getBytesReserved() const { return bytesReserved; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor;
+    char* limit;
+    size_t blockSize;
+    size_t bytesUsed;
+    size_t bytesReserved;
+
+    void addBlock(size_t bytes);
+};
+
+// Thread-safe interning on top of an Arena: equal strings are stored once
+// and always come back as the same pointer. Like the arena it only grows.
+// A pool nobody shares gains nothing from interning; built with interned
+// false it just copies each string into the arena.
+class StringPool {
+public:
+    explicit StringPool(bool interned = true);
+
+    // Returns the pooled copy of text (not NUL-terminated), adding it first
+    // if the pool has not seen it yet.
+    const char* intern(StringRef text);
+    void reserve(size_t bytes);
+
+    size_t getEntryCount() const;
+    size_t getBytesUsed() const;
+
+private:
+    struct Hash {
+        size_t operator()(const StringRef& text) const;
+    };
+    struct Equal {
+        bool operator()(const StringRef& a, const StringRef& b) const {
+            return a.length == b.length && std::memcmp(a.data, b.data, a.length) == 0;
+        }
+    };
+
+    mutable std::mutex poolMutex;
+    Arena arena;
+    bool interned;
+    size_t copies; // strings stored without interning
+    std::unordered_set<StringRef, Hash, Equal> entries;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "JsonEscape.h"
+
+using namespace std;
+
+string escapeJsonString(const string& input) {
+    return escapeJsonString(StringRef(input));
+}
+
+string escapeJsonString(StringRef input) {
+    string escaped;
+    escaped.reserve(input.length);
+    for (size_t i = 0; i < input.length; ++i) {
+        char c = input.data[i];
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
@@ -0,0 +1,12 @@
+#ifndef JSONESCAPE_H
+#define JSONESCAPE_H
+
+#include "Arena.h"
+#include <string>
+
+// Escapes text for use inside a JSON string literal (quotes, backslashes
+// and the common control characters).
+std::string escapeJsonString(StringRef input);
+std::string escapeJsonString(const std::string& input);
+
+#endif
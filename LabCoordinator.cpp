@@ -0,0 +1,233 @@
+#include "LabCoordinator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <unordered_set>
+
+using namespace std;
+
+namespace {
+
+template <typename R>
+future<R> ready(R value) {
+    promise<R> result;
+    result.set_value(value);
+    return result.get_future();
+}
+
+}
+
+LabCoordinator::LabCoordinator(const string& rootDir, StartupMode startupMode)
+    : root(rootDir), mode(startupMode), directory(make_shared<StringPool>()) {
+    if (!createDirectories(root)) {
+        Logger::instance().log(LogLevel::ERROR, "data_dir_error", "Error creating lab root " + root);
+    }
+    detector = make_shared<AnomalyDetector>(root + "/alerts.log");
+}
+
+LabCoordinator::~LabCoordinator() {
+    for (Shard* shard : allShards()) {
+        {
+            lock_guard<mutex> lock(shard->queueMutex);
+            shard->stopping = true;
+        }
+        shard->queueReady.notify_one();
+    }
+    for (Shard* shard : allShards()) {
+        if (shard->worker.joinable()) {
+            shard->worker.join();
+        }
+        shard->system.reset();
+    }
+}
+
+void LabCoordinator::runWorker(Shard* shard) {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(shard->queueMutex);
+            shard->queueReady.wait(lock, [shard] { return shard->stopping || !shard->tasks.empty(); });
+            if (shard->tasks.empty()) {
+                return; // stopping, and everything queued has run
+            }
+            task = move(shard->tasks.front());
+            shard->tasks.pop_front();
+        }
+        task();
+    }
+}
+
+bool LabCoordinator::addLab(const string& name) {
+    string labRoot = root + "/" + name;
+    Shard* shard;
+    {
+        lock_guard<mutex> lock(shardsMutex);
+        if (name.empty() || shards.count(name) || shards.size() >= AnomalyDetector::NO_DOOR) {
+            return false;
+        }
+        uint16_t door = static_cast<uint16_t>(shards.size());
+        unique_ptr<Shard> created(new Shard());
+        created->name = name;
+        shard = created.get();
+
+        StartupMode startupMode = mode;
+        shared_ptr<StringPool> pool = directory;
+        shared_ptr<AnomalyDetector> sharedDetector = detector;
+        detector->setDoorName(door, name);
+        // set before the shard is visible, so a query can always wait on loaded
+        shard->loaded = post<bool>(*shard, [shard, labRoot, startupMode, pool, sharedDetector, door]() {
+            shard->system.reset(new RFIDSystem(labRoot, startupMode, pool, sharedDetector, door));
+            return true;
+        }).share();
+        shards[name] = move(created);
+    }
+    shard->worker = thread(&LabCoordinator::runWorker, shard);
+    Logger::instance().log(LogLevel::INFO, "lab_added", "Lab " + name + " started at " + labRoot,
+                           {{"lab", name}});
+    return true;
+}
+
+vector<string> LabCoordinator::getLabNames() const {
+    lock_guard<mutex> lock(shardsMutex);
+    vector<string> names;
+    for (const auto& entry : shards) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+LabCoordinator::Shard* LabCoordinator::findShard(const string& name) const {
+    lock_guard<mutex> lock(shardsMutex);
+    auto it = shards.find(name);
+    return it == shards.end() ? nullptr : it->second.get();
+}
+
+vector<LabCoordinator::Shard*> LabCoordinator::allShards() const {
+    lock_guard<mutex> lock(shardsMutex);
+    vector<Shard*> result;
+    for (const auto& entry : shards) {
+        result.push_back(entry.second.get());
+    }
+    return result;
+}
+
+RFIDSystem& LabCoordinator::loadedSystem(Shard& shard) {
+    shard.loaded.wait();
+    return *shard.system;
+}
+
+RFIDSystem* LabCoordinator::getLab(const string& name) {
+    Shard* shard = findShard(name);
+    if (!shard) {
+        return nullptr;
+    }
+    return &loadedSystem(*shard);
+}
+
+future<bool> LabCoordinator::scan(const string& lab, const string& userId) {
+    Shard* shard = findShard(lab);
+    if (!shard) {
+        return ready(false);
+    }
+    return post<bool>(*shard, [shard, userId]() { return shard->system->scanRFID(userId); });
+}
+
+future<bool> LabCoordinator::addUser(const string& lab, const string& id, const string& name, const string& role) {
+    Shard* shard = findShard(lab);
+    if (!shard) {
+        return ready(false);
+    }
+    return post<bool>(*shard, [shard, id, name, role]() {
+        if (shard->system->findUser(id)) {
+            return false;
+        }
+        shard->system->addUser(id, name, role);
+        return true;
+    });
+}
+
+vector<UserLocation> LabCoordinator::locateUser(const string& userId) {
+    vector<Shard*> targets = allShards();
+    vector<future<UserLocation>> answers;
+    for (Shard* shard : targets) {
+        answers.push_back(async(launch::async, [shard, userId]() {
+            UserLocation location;
+            location.lab = shard->name;
+            location.lastScan = 0;
+            // registration, status and last scan all from one epoch
+            SystemSnapshot snap = loadedSystem(*shard).snapshot();
+            const vector<UserRecord>& users = snap.getUsers();
+            bool registered = any_of(users.begin(), users.end(), [&](const UserRecord& user) {
+                return user.id() == userId;
+            });
+            if (!registered) {
+                return location; // empty status: not registered here
+            }
+            location.status = snap.getStatus(userId);
+            if (location.status == "IN") {
+                const LogRecord* last = snap.findLastLog(userId);
+                if (last) {
+                    location.lastScan = last->timestamp;
+                }
+            }
+            return location;
+        }));
+    }
+
+    vector<UserLocation> locations;
+    for (auto& answer : answers) {
+        UserLocation location = answer.get();
+        if (!location.status.empty()) {
+            locations.push_back(location);
+        }
+    }
+    stable_sort(locations.begin(), locations.end(), [](const UserLocation& a, const UserLocation& b) {
+        if ((a.status == "IN") != (b.status == "IN")) {
+            return a.status == "IN";
+        }
+        return a.lastScan > b.lastScan;
+    });
+    return locations;
+}
+
+OccupancyReport LabCoordinator::getOccupancy() {
+    typedef pair<LabOccupancy, vector<string>> LabPresence;
+    vector<Shard*> targets = allShards();
+    vector<future<LabPresence>> answers;
+    for (Shard* shard : targets) {
+        answers.push_back(async(launch::async, [shard]() {
+            SystemSnapshot snap = loadedSystem(*shard).snapshot();
+            LabPresence presence;
+            presence.first.lab = shard->name;
+            presence.first.users = snap.getUsers().size();
+            for (const auto& entry : snap.getStatusMap()) {
+                if (entry.second == "IN") {
+                    presence.second.push_back(entry.first);
+                }
+            }
+            presence.first.present = presence.second.size();
+            return presence;
+        }));
+    }
+
+    OccupancyReport report;
+    unordered_set<string> present;
+    for (auto& answer : answers) {
+        LabPresence presence = answer.get();
+        report.labs.push_back(presence.first);
+        present.insert(presence.second.begin(), presence.second.end());
+    }
+    report.buildingPresent = present.size();
+    return report;
+}
+
+bool LabCoordinator::saveAll() {
+    vector<future<bool>> results;
+    for (Shard* shard : allShards()) {
+        results.push_back(post<bool>(*shard, [shard]() { return shard->system->saveAllData(); }));
+    }
+    bool ok = true;
+    for (auto& result : results) {
+        ok = result.get() && ok;
+    }
+    return ok;
+}
@@ -0,0 +1,109 @@
+#ifndef LABCOORDINATOR_H
+#define LABCOORDINATOR_H
+
+#include "RFIDSystem.h"
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct UserLocation {
+    std::string lab;
+    std::string status;    // IN or OUT in that lab
+    std::time_t lastScan;  // 0 if the lab has no loaded log for the user
+};
+
+struct LabOccupancy {
+    std::string lab;
+    size_t present; // users currently IN
+    size_t users;   // registered users
+};
+
+struct OccupancyReport {
+    std::vector<LabOccupancy> labs;
+    size_t buildingPresent; // distinct users IN in at least one lab
+};
+
+// Hosts one RFIDSystem per lab in one process, each under <root>/<lab> with
+// its own files and its own worker thread. Scans and user changes for a lab
+// run on that lab's thread. Cross-lab queries read every lab's snapshot in
+// parallel, off the worker threads so they never wait behind queued scans,
+// and are merged here. All labs intern user details in one StringPool, so a
+// person registered in several labs is stored once, and feed one
+// AnomalyDetector with a door per lab, alerting to <root>/alerts.log.
+class LabCoordinator {
+public:
+    explicit LabCoordinator(const std::string& root, StartupMode mode = StartupMode::LAZY_HISTORY);
+    ~LabCoordinator();
+    LabCoordinator(const LabCoordinator&) = delete;
+    LabCoordinator& operator=(const LabCoordinator&) = delete;
+
+    // Starts the lab's thread and loads its data there; returns at once, so
+    // labs added back to back load in parallel. False if the name is taken.
+    bool addLab(const std::string& name);
+    std::vector<std::string> getLabNames() const;
+    // Waits until the lab has loaded; nullptr for an unknown lab.
+    RFIDSystem* getLab(const std::string& name);
+
+    std::future<bool> scan(const std::string& lab, const std::string& userId);
+    std::future<bool> addUser(const std::string& lab, const std::string& id,
+                              const std::string& name, const std::string& role);
+
+    // Labs where the user is registered, those they are IN first, most
+    // recent scan first.
+    std::vector<UserLocation> locateUser(const std::string& userId);
+    OccupancyReport getOccupancy();
+    bool saveAll();
+
+    const StringPool& getDirectory() const { return *directory; }
+    AnomalyDetector& getDetector() { return *detector; }
+
+private:
+    struct Shard {
+        std::string name;
+        std::unique_ptr<RFIDSystem> system;
+        std::thread worker;
+        std::mutex queueMutex;
+        std::condition_variable queueReady;
+        std::deque<std::function<void()>> tasks;
+        bool stopping;
+        std::shared_future<bool> loaded; // system is set once this is ready
+
+        Shard() : stopping(false) {}
+    };
+
+    std::string root;
+    StartupMode mode;
+    std::shared_ptr<StringPool> directory;
+    std::shared_ptr<AnomalyDetector> detector;
+    mutable std::mutex shardsMutex;
+    std::map<std::string, std::unique_ptr<Shard>> shards;
+
+    static void runWorker(Shard* shard);
+    static RFIDSystem& loadedSystem(Shard& shard);
+    Shard* findShard(const std::string& name) const;
+    std::vector<Shard*> allShards() const;
+
+    // Queues fn on the shard's thread; tasks of one shard run in order.
+    template <typename R>
+    std::future<R> post(Shard& shard, std::function<R()> fn) {
+        std::shared_ptr<std::packaged_task<R()>> task = std::make_shared<std::packaged_task<R()>>(fn);
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(shard.queueMutex);
+            shard.tasks.push_back([task]() { (*task)(); });
+        }
+        shard.queueReady.notify_one();
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "Logger.h"
+#include "JsonEscape.h"
+#include <chrono>
+
+using namespace std;
+
+const char* const BACKGROUND_FIELD = "background";
+
+bool LogEvent::hasField(const string& name) const {
+    for (const auto& field : fields) {
+        if (field.first == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "INFO";
+}
+
+Logger::Logger(size_t capacity)
+    : enqueuePos(0), dequeuePos(0), written(0), dropped(0),
+      minLevel(static_cast<uint8_t>(LogLevel::INFO)), running(false), writerIdle(false) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+        cells[i].sequence.store(i, memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+bool Logger::start(const string& path) {
+    if (running.load()) {
+        return true;
+    }
+    // without the file the writer still runs, so events reach the sink
+    // instead of piling up in the ring
+    file.open(path, ios::app);
+    running.store(true);
+    writer = thread(&Logger::writerLoop, this);
+    return file.is_open();
+}
+
+void Logger::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(wakeMutex);
+    }
+    wakeCv.notify_one();
+    writer.join();
+    file.close();
+    {
+        lock_guard<mutex> lock(flushMutex);
+    }
+    flushCv.notify_all();
+}
+
+void Logger::setSink(Sink newSink) {
+    // only safe before start(); the writer reads the sink without locking
+    sink = move(newSink);
+}
+
+bool Logger::log(LogLevel level, const string& event, const string& message,
+                 vector<pair<string, string>> fields) {
+    if (static_cast<uint8_t>(level) < minLevel.load(memory_order_relaxed)) {
+        return false;
+    }
+
+    LogEvent ev;
+    ev.level = level;
+    ev.timestamp = time(nullptr);
+    ev.event = event;
+    ev.message = message;
+    ev.fields = move(fields);
+
+    if (!tryPush(move(ev))) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    if (writerIdle.load(memory_order_relaxed)) {
+        wakeCv.notify_one();
+    }
+    return true;
+}
+
+void Logger::flush() {
+    if (!running.load()) {
+        return;
+    }
+    // every slot claimed so far, including ones whose producer is still
+    // filling them in; the writer consumes slots in order, so once it has
+    // written this many the caller's own events are out
+    uint64_t target = enqueuePos.load(memory_order_acquire);
+    {
+        lock_guard<mutex> lock(wakeMutex);
+    }
+    wakeCv.notify_one();
+
+    unique_lock<mutex> lock(flushMutex);
+    flushCv.wait(lock, [&] {
+        return written.load(memory_order_acquire) >= target || !running.load();
+    });
+}
+
+// Bounded multi-producer ring: each cell carries a sequence number that
+// tells producers and the consumer whose turn it is, so no locks are taken.
+bool Logger::tryPush(LogEvent&& ev) {
+    size_t pos = enqueuePos.load(memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+    cell->event = move(ev);
+    cell->sequence.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool Logger::tryPop(LogEvent& ev) {
+    size_t pos = dequeuePos.load(memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // empty
+        } else {
+            pos = dequeuePos.load(memory_order_relaxed);
+        }
+    }
+    ev = move(cell->event);
+    cell->sequence.store(pos + mask + 1, memory_order_release);
+    return true;
+}
+
+void Logger::writerLoop() {
+    LogEvent ev;
+    while (true) {
+        bool stopping = !running.load();
+        size_t batch = 0;
+        while (tryPop(ev)) {
+            writeEvent(ev);
+            ++batch;
+        }
+
+        if (batch > 0) {
+            if (file.is_open()) {
+                file.flush();
+            }
+            written.fetch_add(batch, memory_order_release);
+            {
+                lock_guard<mutex> lock(flushMutex);
+            }
+            flushCv.notify_all();
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        unique_lock<mutex> lock(wakeMutex);
+        writerIdle.store(true);
+        wakeCv.wait_for(lock, chrono::milliseconds(50));
+        writerIdle.store(false);
+    }
+}
+
+void Logger::writeEvent(const LogEvent& ev) {
+    if (file.is_open()) {
+        writeJson(ev);
+    }
+    if (sink) {
+        sink(ev);
+    }
+}
+
+void Logger::writeJson(const LogEvent& ev) {
+    file << "{\"ts\":" << ev.timestamp
+         << ",\"level\":\"" << logLevelName(ev.level) << "\""
+         << ",\"event\":\"" << escapeJsonString(ev.event) << "\""
+         << ",\"msg\":\"" << escapeJsonString(ev.message) << "\"";
+    for (const auto& field : ev.fields) {
+        file << ",\"" << escapeJsonString(field.first) << "\":\"" << escapeJsonString(field.second) << "\"";
+    }
+    file << "}\n";
+}
@@ -0,0 +1,103 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+struct LogEvent {
+    LogLevel level;
+    std::time_t timestamp;
+    std::string event;   // machine-readable event name, e.g. "scan"
+    std::string message; // human-readable text for the front end
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    LogEvent() : level(LogLevel::INFO), timestamp(0) {}
+
+    bool hasField(const std::string& name) const;
+};
+
+// Events from background work (saves, history loading) carry this field so
+// an interactive sink can leave them out; the log file still records them.
+extern const char* const BACKGROUND_FIELD;
+
+// Asynchronous event logger. Producers push into a bounded lock-free ring
+// and never touch the file or the console; a background writer drains the
+// ring, appends one JSON object per line to the log file and hands each
+// event to the optional sink (the console front end).
+class Logger {
+public:
+    typedef std::function<void(const LogEvent&)> Sink;
+
+    explicit Logger(size_t capacity = 4096);
+    ~Logger();
+
+    static Logger& instance();
+
+    // Starts the writer; returns false if the file could not be opened, in
+    // which case events still reach the sink.
+    bool start(const std::string& path);
+    void stop();
+    void setSink(Sink sink);
+    void setMinLevel(LogLevel level) { minLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+
+    // returns false if the event was filtered or the ring was full
+    bool log(LogLevel level, const std::string& event, const std::string& message,
+             std::vector<std::pair<std::string, std::string>> fields = {});
+
+    // blocks until every event logged so far has been written
+    void flush();
+
+    uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogEvent event;
+    };
+
+    bool tryPush(LogEvent&& ev);
+    bool tryPop(LogEvent& ev);
+    void writerLoop();
+    void writeEvent(const LogEvent& ev);
+    void writeJson(const LogEvent& ev);
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    std::atomic<size_t> enqueuePos;
+    std::atomic<size_t> dequeuePos;
+
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint8_t> minLevel;
+    std::atomic<bool> running;
+    std::atomic<bool> writerIdle;
+
+    std::ofstream file;
+    Sink sink;
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::mutex flushMutex;
+    std::condition_variable flushCv;
+};
+
+const char* logLevelName(LogLevel level);
+
+#endif
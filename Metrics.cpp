@@ -0,0 +1,261 @@
+#include "Metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const char* OP_NAMES[] = {"scan", "save", "load", "export"};
+
+const char* COUNTER_NAMES[] = {
+    "rfid_scans_total", "rfid_scan_rejects_total", "rfid_scan_denials_total", "rfid_bytes_written_total",
+    "rfid_anomaly_alerts_total"
+};
+const char* COUNTER_HELP[] = {
+    "Successful card scans",
+    "Scans rejected for an unknown user",
+    "Entries refused by the access policy",
+    "Bytes written to the binary data file and JSON export",
+    "Alerts raised by the scan anomaly detector"
+};
+
+const char* GAUGE_NAMES[] = {
+    "rfid_users", "rfid_scan_logs", "rfid_data_file_bytes",
+    "rfid_time_to_first_scan_microseconds", "rfid_history_load_microseconds"
+};
+const char* GAUGE_HELP[] = {
+    "Registered users",
+    "Scan log entries held in memory",
+    "Size of the binary data file",
+    "Time from startup until scans were accepted",
+    "Time spent loading historical logs after startup"
+};
+
+// label values escape backslash, quote and newline
+string labelValue(const string& value) {
+    string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// single writer per shard, so a plain load/store pair is enough and avoids
+// a locked read-modify-write on the hot path
+inline void bump(atomic<uint64_t>& cell, uint64_t amount) {
+    cell.store(cell.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+}
+
+Metrics::Shard::Shard() {
+    for (int op = 0; op < static_cast<int>(MetricOp::COUNT); ++op) {
+        for (int b = 0; b < BUCKETS; ++b) {
+            buckets[op][b].store(0, memory_order_relaxed);
+        }
+        sums[op].store(0, memory_order_relaxed);
+        maxima[op].store(0, memory_order_relaxed);
+    }
+    for (int c = 0; c < static_cast<int>(MetricCounter::COUNT); ++c) {
+        counters[c].store(0, memory_order_relaxed);
+    }
+}
+
+Metrics::Metrics() {}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+// Hands the thread's shard back when the thread exits.
+struct Metrics::ShardLease {
+    Shard* shard;
+
+    ShardLease() : shard(nullptr) {}
+    ~ShardLease() {
+        if (shard) {
+            Metrics::instance().releaseShard(shard);
+        }
+    }
+};
+
+Metrics::Shard& Metrics::localShard() {
+    thread_local ShardLease lease;
+    if (!lease.shard) {
+        lease.shard = acquireShard();
+    }
+    return *lease.shard;
+}
+
+// A reused shard keeps its counts, so totals are unchanged; the mutex
+// orders the old owner's last writes before the new owner's first.
+Metrics::Shard* Metrics::acquireShard() {
+    lock_guard<mutex> lock(shardsMutex);
+    if (!freeShards.empty()) {
+        Shard* shard = freeShards.back();
+        freeShards.pop_back();
+        return shard;
+    }
+    shards.push_back(unique_ptr<Shard>(new Shard()));
+    return shards.back().get();
+}
+
+void Metrics::releaseShard(Shard* shard) {
+    lock_guard<mutex> lock(shardsMutex);
+    freeShards.push_back(shard);
+}
+
+int Metrics::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(2 * SUB_BUCKETS)) {
+        return static_cast<int>(value);
+    }
+    int shift = (63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+    int index = shift * SUB_BUCKETS + static_cast<int>(value >> shift);
+    // the last bucket ends at 2^63 - 1; anything above is counted there too
+    return index < BUCKETS ? index : BUCKETS - 1;
+}
+
+uint64_t Metrics::bucketUpperBound(int index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t mantissa = static_cast<uint64_t>(index % SUB_BUCKETS + SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void Metrics::recordLatency(MetricOp op, uint64_t nanos) {
+    Shard& shard = localShard();
+    int o = static_cast<int>(op);
+    bump(shard.buckets[o][bucketIndex(nanos)], 1);
+    bump(shard.sums[o], nanos);
+    if (nanos > shard.maxima[o].load(memory_order_relaxed)) {
+        shard.maxima[o].store(nanos, memory_order_relaxed);
+    }
+}
+
+void Metrics::increment(MetricCounter counter, uint64_t amount) {
+    bump(localShard().counters[static_cast<int>(counter)], amount);
+}
+
+void Metrics::setGauge(MetricGauge gauge, int64_t value, const string& lab) {
+    lock_guard<mutex> lock(gaugesMutex);
+    gauges[lab].values[static_cast<int>(gauge)] = value;
+}
+
+LatencySummary Metrics::getLatency(MetricOp op) const {
+    int o = static_cast<int>(op);
+    vector<uint64_t> merged(BUCKETS, 0);
+    LatencySummary summary = {0, 0, 0, 0, 0, 0};
+
+    {
+        lock_guard<mutex> lock(shardsMutex);
+        for (const auto& shard : shards) {
+            for (int b = 0; b < BUCKETS; ++b) {
+                uint64_t n = shard->buckets[o][b].load(memory_order_relaxed);
+                merged[b] += n;
+                summary.count += n;
+            }
+            summary.sumNanos += shard->sums[o].load(memory_order_relaxed);
+            uint64_t shardMax = shard->maxima[o].load(memory_order_relaxed);
+            if (shardMax > summary.maxNanos) {
+                summary.maxNanos = shardMax;
+            }
+        }
+    }
+
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    const double quantiles[] = {0.50, 0.90, 0.99};
+    uint64_t* targets[] = {&summary.p50Nanos, &summary.p90Nanos, &summary.p99Nanos};
+    for (int q = 0; q < 3; ++q) {
+        uint64_t rank = static_cast<uint64_t>(quantiles[q] * summary.count + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += merged[b];
+            if (seen >= rank) {
+                uint64_t bound = bucketUpperBound(b);
+                *targets[q] = bound < summary.maxNanos ? bound : summary.maxNanos;
+                break;
+            }
+        }
+    }
+    return summary;
+}
+
+uint64_t Metrics::getCounter(MetricCounter counter) const {
+    uint64_t total = 0;
+    lock_guard<mutex> lock(shardsMutex);
+    for (const auto& shard : shards) {
+        total += shard->counters[static_cast<int>(counter)].load(memory_order_relaxed);
+    }
+    return total;
+}
+
+int64_t Metrics::getGauge(MetricGauge gauge, const string& lab) const {
+    lock_guard<mutex> lock(gaugesMutex);
+    auto it = gauges.find(lab);
+    return it == gauges.end() ? 0 : it->second.values[static_cast<int>(gauge)];
+}
+
+string Metrics::renderText() const {
+    stringstream out;
+
+    out << "# HELP rfid_operation_latency_seconds Latency of core RFIDSystem operations\n";
+    out << "# TYPE rfid_operation_latency_seconds summary\n";
+    for (int o = 0; o < static_cast<int>(MetricOp::COUNT); ++o) {
+        LatencySummary s = getLatency(static_cast<MetricOp>(o));
+        const char* name = OP_NAMES[o];
+        out << "rfid_operation_latency_seconds{op=\"" << name << "\",quantile=\"0.5\"} " << s.p50Nanos / 1e9 << "\n";
+        out << "rfid_operation_latency_seconds{op=\"" << name << "\",quantile=\"0.9\"} " << s.p90Nanos / 1e9 << "\n";
+        out << "rfid_operation_latency_seconds{op=\"" << name << "\",quantile=\"0.99\"} " << s.p99Nanos / 1e9 << "\n";
+        out << "rfid_operation_latency_seconds_sum{op=\"" << name << "\"} " << s.sumNanos / 1e9 << "\n";
+        out << "rfid_operation_latency_seconds_count{op=\"" << name << "\"} " << s.count << "\n";
+    }
+
+    for (int c = 0; c < static_cast<int>(MetricCounter::COUNT); ++c) {
+        out << "# HELP " << COUNTER_NAMES[c] << " " << COUNTER_HELP[c] << "\n";
+        out << "# TYPE " << COUNTER_NAMES[c] << " counter\n";
+        out << COUNTER_NAMES[c] << " " << getCounter(static_cast<MetricCounter>(c)) << "\n";
+    }
+
+    lock_guard<mutex> lock(gaugesMutex);
+    for (int g = 0; g < static_cast<int>(MetricGauge::COUNT); ++g) {
+        out << "# HELP " << GAUGE_NAMES[g] << " " << GAUGE_HELP[g] << "\n";
+        out << "# TYPE " << GAUGE_NAMES[g] << " gauge\n";
+        for (const auto& entry : gauges) {
+            out << GAUGE_NAMES[g] << "{lab=\"" << labelValue(entry.first) << "\"} " << entry.second.values[g] << "\n";
+        }
+    }
+
+    return out.str();
+}
+
+bool Metrics::writeExposition(const string& path) const {
+    // write-then-rename so a scraper never sees a half-written file
+    string tmpPath = path + ".tmp";
+    {
+        ofstream file(tmpPath);
+        if (!file) {
+            return false;
+        }
+        file << renderText();
+        if (!file) {
+            return false;
+        }
+    }
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,128 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class MetricOp : uint8_t {
+    SCAN,
+    SAVE,
+    LOAD,
+    EXPORT,
+    COUNT
+};
+
+enum class MetricCounter : uint8_t {
+    SCANS,
+    REJECTS,
+    DENIALS,
+    BYTES_WRITTEN,
+    ALERTS,
+    COUNT
+};
+
+enum class MetricGauge : uint8_t {
+    USERS,
+    LOGS,
+    DATA_FILE_BYTES,
+    TIME_TO_FIRST_SCAN_MICROS,
+    HISTORY_LOAD_MICROS,
+    COUNT
+};
+
+struct LatencySummary {
+    uint64_t count;
+    uint64_t sumNanos;
+    uint64_t maxNanos;
+    uint64_t p50Nanos;
+    uint64_t p90Nanos;
+    uint64_t p99Nanos;
+};
+
+// Process-wide metrics registry. Latency histograms use log-linear buckets
+// (8 sub-buckets per power of two, ~12% relative error) and are recorded
+// into a per-thread shard, so the hot path is a couple of uncontended
+// relaxed stores. Readers sum the shards when rendering. A thread's shard
+// keeps its counts after the thread exits and is handed to the next new
+// thread, so there are only as many shards as threads alive at once.
+// Gauges describe one lab's data and are kept per lab, rendered with a lab
+// label.
+class Metrics {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKETS = (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    static Metrics& instance();
+
+    void recordLatency(MetricOp op, uint64_t nanos);
+    void increment(MetricCounter counter, uint64_t amount = 1);
+    void setGauge(MetricGauge gauge, int64_t value, const std::string& lab);
+
+    LatencySummary getLatency(MetricOp op) const;
+    uint64_t getCounter(MetricCounter counter) const;
+    int64_t getGauge(MetricGauge gauge, const std::string& lab) const;
+
+    // Prometheus-style text exposition
+    std::string renderText() const;
+    bool writeExposition(const std::string& path) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> buckets[static_cast<int>(MetricOp::COUNT)][BUCKETS];
+        std::atomic<uint64_t> sums[static_cast<int>(MetricOp::COUNT)];
+        std::atomic<uint64_t> maxima[static_cast<int>(MetricOp::COUNT)];
+        std::atomic<uint64_t> counters[static_cast<int>(MetricCounter::COUNT)];
+
+        Shard();
+    };
+
+    Metrics();
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    struct ShardLease;
+
+    Shard& localShard();
+    Shard* acquireShard();
+    void releaseShard(Shard* shard);
+
+    struct GaugeSet {
+        int64_t values[static_cast<int>(MetricGauge::COUNT)];
+
+        GaugeSet() : values() {}
+    };
+
+    mutable std::mutex shardsMutex;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Shard*> freeShards; // left by exited threads
+    mutable std::mutex gaugesMutex;
+    std::map<std::string, GaugeSet> gauges; // by lab
+};
+
+// Records the lifetime of the enclosing scope into the given histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(MetricOp timedOp)
+        : op(timedOp), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::instance().recordLatency(op,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    MetricOp op;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
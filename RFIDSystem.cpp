@@ -1,4 +1,9 @@
 #include "RFIDSystem.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "JsonEscape.h"
+#include "TimeFormat.h"
+#include "TableRenderer.h"
 #include <iostream>
 #include <algorithm>
 #include <iomanip>
@@ -7,261 +12,825 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sstream>
+#include <chrono>
 
 using namespace std;
 
-RFIDSystem::RFIDSystem() {
+RFIDSystem::RFIDSystem(const string& root, StartupMode mode, shared_ptr<StringPool> directory,
+                       shared_ptr<AnomalyDetector> sharedDetector, uint16_t detectorDoor)
+    : dataRoot(root), users(make_shared<const vector<UserRecord>>()),
+      userStrings(directory ? directory : make_shared<StringPool>(false)), sharedDirectory(directory != nullptr),
+      logCount(0), lastTimestamp(0),
+      unsortedFrom(SIZE_MAX), generation(0), baseStatus(make_shared<const StatusMap>()),
+      baseLogCount(0), lastSequence(0), resetSequence(0), policyLoaded(false),
+      detector(sharedDetector), door(detectorDoor),
+      historyPending(false), pendingHistoryCount(0),
+      saveRequests(0), savesDone(0), saverStopping(false), snapshotSequence(0) {
+    auto start = chrono::steady_clock::now();
+    publishLocked();
     createDataDirectory();
+    if (!detector) {
+        detector = make_shared<AnomalyDetector>(dataPath("alerts.log"));
+    }
+    reloadAccessPolicy();
+
+    if (!loadData(mode == StartupMode::LAZY_HISTORY)) {
+        logEvent(LogLevel::INFO, "load_empty", "No system data found, starting with empty system...");
+    }
 
-    if (!loadSystemData()) {
-        cout << "No system data found, starting with empty system..." << endl;
+    {
+        lock_guard<mutex> lock(writeMutex);
+        seedDetectorLocked();
     }
+    saver = thread(&RFIDSystem::saverLoop, this);
 
-    for (const auto& user : users) {
-        if (userStatus.find(user.id) == userStatus.end()) {
-            userStatus[user.id] = "OUT";
+    auto micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    Metrics::instance().setGauge(MetricGauge::TIME_TO_FIRST_SCAN_MICROS, micros, dataRoot);
+    logEvent(LogLevel::INFO, "startup_ready",
+             "Ready for scans after " + to_string(micros / 1000) + " ms",
+             {{"micros", to_string(micros)}});
+}
+
+RFIDSystem::~RFIDSystem() {
+    {
+        lock_guard<mutex> lock(saverMutex);
+        saverStopping = true;
+    }
+    saverWake.notify_one();
+    saver.join(); // after a last save of anything still pending
+    if (historyLoader.joinable()) {
+        historyLoader.join();
+    }
+}
+
+void RFIDSystem::logEvent(LogLevel level, const string& event, const string& message,
+                          vector<pair<string, string>> fields, bool background) {
+    fields.push_back(make_pair("lab", dataRoot));
+    if (background) {
+        fields.push_back(make_pair(BACKGROUND_FIELD, "true"));
+    }
+    Logger::instance().log(level, event, message, move(fields));
+}
+
+bool createDirectories(const string& path) {
+    for (size_t end = path.find('/', 1); ; end = path.find('/', end + 1)) {
+        string prefix = path.substr(0, end);
+        struct stat st;
+        if (stat(prefix.c_str(), &st) == -1 && mkdir(prefix.c_str(), 0755) != 0) {
+            return false;
+        }
+        if (end == string::npos) {
+            return true;
         }
     }
 }
 
 void RFIDSystem::createDataDirectory() {
-    struct stat st = {0};
-    if (stat("data", &st) == -1) {
-        if (mkdir("data", 0755) != 0) {
-            cerr << "Error creating data directory" << endl;
+    // a lab root like labs/chem needs its parent too
+    if (!createDirectories(dataRoot)) {
+        logEvent(LogLevel::ERROR, "data_dir_error", "Error creating data directory " + dataRoot);
+    }
+}
+
+SystemSnapshot RFIDSystem::snapshot() const {
+    return SystemSnapshot(atomic_load(&epoch));
+}
+
+void RFIDSystem::publishLocked() {
+    shared_ptr<Epoch> next = make_shared<Epoch>();
+    next->users = users;
+    next->userStrings = userStrings;
+    next->baseStatus = baseStatus;
+    next->baseLogCount = baseLogCount;
+    next->segments = segments;
+    next->unsortedFrom = unsortedFrom;
+    next->generation = generation;
+    next->pendingHistory = pendingHistoryCount;
+    next->resetSequence = resetSequence;
+    atomic_store(&epoch, shared_ptr<const Epoch>(move(next)));
+}
+
+// Appends into the current segment and publishes the slot by bumping its
+// count. Returns true when readers need a new epoch, i.e. a segment was
+// added or the logs stopped being in time order; the caller publishes.
+bool RFIDSystem::appendLogLocked(StringRef userId, StringRef userName, StringRef action, time_t timestamp,
+                                 uint64_t sequence) {
+    bool republish = false;
+    if (segments.empty() || segments.back()->count.load(memory_order_relaxed) == LogSegment::CAPACITY) {
+        segments.push_back(make_shared<LogSegment>(sequence));
+        republish = true;
+    }
+    if (logCount > 0 && timestamp < lastTimestamp && unsortedFrom == SIZE_MAX) {
+        unsortedFrom = logCount; // wall clock went backwards
+        republish = true;
+    }
+
+    LogSegment& segment = *segments.back();
+    size_t slot = segment.count.load(memory_order_relaxed);
+    segment.entries[slot] = LogRecord(segment.strings, userId, userName, action, timestamp,
+                                      static_cast<uint32_t>(sequence - segment.firstSequence));
+    segment.count.store(slot + 1, memory_order_release);
+    ++logCount;
+    lastTimestamp = max(lastTimestamp, timestamp);
+    return republish;
+}
+
+// Starts the change feed over: consumers behind this point have to take
+// the current state again. The caller publishes.
+void RFIDSystem::resetFeedLocked() {
+    resetSequence = ++lastSequence;
+}
+
+// Tells the detector which cards are inside this door, after the status
+// was loaded or cleared.
+void RFIDSystem::seedDetectorLocked() {
+    detector->resetDoor(door);
+    const vector<UserRecord>& table = *users;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (userInside[i]) {
+            detector->markInside(table[i].id(), door);
         }
     }
 }
 
+// Moves the status base forward to a snapshot whose full status map a
+// reader has already built, so later readers replay fewer logs.
+void RFIDSystem::rebaseStatus(const SystemSnapshot& snap, const shared_ptr<const StatusMap>& status) {
+    lock_guard<mutex> lock(writeMutex);
+    if (snap.getGeneration() != generation || snap.getLogCount() <= baseLogCount) {
+        return;
+    }
+    baseStatus = status;
+    baseLogCount = snap.getLogCount();
+    publishLocked();
+}
+
 void RFIDSystem::addUser(const string& id, const string& name, const string& role) {
-    users.emplace_back(id, name, role);
-    userStatus[id] = "OUT";
-    cout << "User added: " << name << " (" << id << ") - " << role << endl;
+    {
+        lock_guard<mutex> lock(writeMutex);
+        shared_ptr<vector<UserRecord>> next = make_shared<vector<UserRecord>>();
+        next->reserve(users->size() + 1);
+        next->assign(users->begin(), users->end());
+        next->push_back(UserRecord(*userStrings, id, name, role, parseUserRole(role), ++lastSequence));
+        users = next;
+        userInside.push_back(false);
+        publishLocked();
+    }
+    logEvent(LogLevel::INFO, "user_added",
+             "User added: " + name + " (" + id + ") - " + role,
+             {{"user_id", id}, {"role", role}});
 
-    saveSystemData();
+    persist();
 }
 
-User* RFIDSystem::findUser(const string& id) {
-    for (auto& user : users) {
-        if (user.id == id) {
+static const UserRecord* findUserIn(const vector<UserRecord>& table, const string& id) {
+    for (const auto& user : table) {
+        if (user.id() == id) {
             return &user;
         }
     }
     return nullptr;
 }
 
-bool RFIDSystem::scanRFID(const string& userId) {
-    User* user = findUser(userId);
-    if (!user) {
-        cout << "ERROR: User ID " << userId << " not found!" << endl;
+const UserRecord* RFIDSystem::findUser(const string& id) const {
+    return findUserIn(*atomic_load(&epoch)->users, id);
+}
+
+bool RFIDSystem::reloadAccessPolicy() {
+    string error;
+    lock_guard<mutex> lock(writeMutex);
+    if (!accessPolicy.loadFromFile(dataPath("access_policy.conf"), error)) {
+        // a typo must not lift every restriction: keep the rules in force,
+        // or refuse every entry until the file is fixed
+        if (policyLoaded) {
+            logEvent(LogLevel::ERROR, "policy_error",
+                     "Access policy not reloaded, keeping the previous rules: " + error);
+        } else {
+            logEvent(LogLevel::ERROR, "policy_error",
+                     "Access policy not loaded, refusing all entries: " + error);
+            accessPolicy.denyAll();
+        }
         return false;
     }
-    string action = (userStatus[userId] == "OUT") ? "IN" : "OUT";
-    userStatus[userId] = action;
+    policyLoaded = true;
+    if (accessPolicy.getRuleCount() > 0) {
+        logEvent(LogLevel::INFO, "policy_loaded",
+                 "Access policy loaded: " + to_string(accessPolicy.getRuleCount()) + " rules");
+    }
+    return true;
+}
+
+bool RFIDSystem::scanRFID(const string& userId) {
+    ScopedTimer timer(MetricOp::SCAN);
+    string name, action, formattedTime;
+    {
+        lock_guard<mutex> lock(writeMutex);
+        const UserRecord* user = findUserIn(*users, userId);
+        if (!user) {
+            Metrics::instance().increment(MetricCounter::REJECTS);
+            logEvent(LogLevel::WARN, "scan_unknown_user",
+                     "ERROR: User ID " + userId + " not found!",
+                     {{"user_id", userId}});
+            return false;
+        }
+        name = user->name().str();
+        size_t index = user - users->data();
+        action = userInside[index] ? "OUT" : "IN";
+
+        // the policy only gates entry; leaving is always allowed
+        time_t now = time(nullptr);
+        if (action == "IN" && !accessPolicy.allows(user->roleType, now)) {
+            Metrics::instance().increment(MetricCounter::DENIALS);
+            string role = user->role().str();
+            logEvent(LogLevel::WARN, "scan_denied",
+                     "ACCESS DENIED: " + name + " (" + userId + ") - " +
+                     role + " not admitted at " + formatTimestamp(now),
+                     {{"user_id", userId}, {"role", role}});
+            return false;
+        }
+        userInside[index] = (action == "IN");
 
-    ScanLog log(userId, user->name, action);
-    dailyLogs.push_back(log);
+        if (appendLogLocked(user->id(), user->name(), action, now, ++lastSequence)) {
+            publishLocked();
+        }
+        detector->observe(user->id(), door, action == "IN", now);
+        formattedTime = formatTimestamp(now);
+    }
+    Metrics::instance().increment(MetricCounter::SCANS);
 
-    cout << "SCAN SUCCESS: " << user->name << " (" << userId << ") - "
-              << action << " at " << log.getFormattedTime() << endl;
+    logEvent(LogLevel::INFO, "scan",
+             "SCAN SUCCESS: " + name + " (" + userId + ") - " +
+             action + " at " + formattedTime,
+             {{"user_id", userId}, {"action", action}});
 
-    saveSystemData();
+    persist();
     return true;
 }
 
 vector<ScanLog> RFIDSystem::searchLogsByUserId(const string& userId) {
+    waitForHistory();
     vector<ScanLog> userLogs;
 
-    for (const auto& log : dailyLogs) {
-        if (log.userId == userId) {
-            userLogs.push_back(log);
+    snapshot().forEachLog([&](const LogRecord& log) {
+        if (log.userId() == userId) {
+            userLogs.push_back(log.toScanLog());
         }
-    }
+    });
 
     sort(userLogs.begin(), userLogs.end());
     return userLogs;
 }
 
 vector<ScanLog> RFIDSystem::getSortedLogs() {
-    vector<ScanLog> sortedLogs = dailyLogs;
-    sort(sortedLogs.begin(), sortedLogs.end());
-    return sortedLogs;
+    waitForHistory();
+    return snapshot().getSortedLogs();
 }
 
+// Time-ordered access to a snapshot's logs. Logs are appended in time
+// order unless the clock was adjusted, so this is normally a direct view
+// and a page of it costs only the rows on the page.
+class SortedLogView {
+public:
+    explicit SortedLogView(const SystemSnapshot& snapshot) : snap(snapshot) {
+        if (!snap.isSorted()) {
+            sorted = snap.getSortedRecords();
+        }
+    }
+    size_t size() const { return snap.getLogCount(); }
+    const LogRecord& operator[](size_t index) const {
+        return sorted.empty() ? snap.getLog(index) : sorted[index];
+    }
+
+private:
+    const SystemSnapshot& snap;
+    vector<LogRecord> sorted;
+};
+
+static void writeString(ofstream& file, StringRef text) {
+    size_t length = text.length;
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(text.data, length);
+}
+
+// Reads the data file through one large buffer. Most fields are a few
+// bytes, and copying them out of the buffer is much cheaper than a
+// stream read call per field.
+class ChunkReader {
+public:
+    static const size_t CHUNK_SIZE = 1 << 20;
+
+    explicit ChunkReader(const char* path)
+        : file(fopen(path, "rb")), buffer(CHUNK_SIZE), pos(0), end(0), consumed(0), size(0), failed(false) {
+        struct stat st;
+        if (file && fstat(fileno(file), &st) == 0) {
+            size = st.st_size;
+        }
+    }
+    ~ChunkReader() {
+        if (file) fclose(file);
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    bool good() const { return !failed; }
+    size_t getOffset() const { return consumed; }
+    size_t getRemaining() const { return size > consumed ? size - consumed : 0; }
+
+    bool read(void* out, size_t length) {
+        char* target = static_cast<char*>(out);
+        while (length > 0) {
+            if (pos == end && !refill()) {
+                failed = true;
+                return false;
+            }
+            size_t n = min(length, end - pos);
+            memcpy(target, &buffer[pos], n);
+            pos += n;
+            consumed += n;
+            target += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    // Reads a length-prefixed string into a reused buffer, so loading does
+    // not allocate once per field.
+    void readString(string& text) {
+        size_t length = 0;
+        read(&length, sizeof(length));
+        text.resize(length);
+        if (length > 0) {
+            read(&text[0], length);
+        }
+    }
+
+private:
+    FILE* file;
+    vector<char> buffer;
+    size_t pos;
+    size_t end;
+    size_t consumed;
+    size_t size;
+    bool failed;
+
+    bool refill() {
+        pos = 0;
+        end = fread(buffer.data(), 1, buffer.size(), file);
+        return end > 0;
+    }
+};
+
 bool RFIDSystem::saveSystemData() {
-    ofstream binFile("data/system_data.bin", ios::binary);
+    return saveDataFile(false);
+}
+
+bool RFIDSystem::saveDataFile(bool background) {
+    ScopedTimer timer(MetricOp::SAVE);
+    lock_guard<mutex> saveLock(saveMutex);
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    shared_ptr<const StatusMap> status = make_shared<const StatusMap>(snap.getStatusMap());
+    const vector<UserRecord>& snapUsers = snap.getUsers();
+
+    // write-then-rename so a crash mid-save leaves the previous file intact
+    string path = dataPath("system_data.bin");
+    string tmpPath = path + ".tmp";
+    ofstream binFile(tmpPath, ios::binary);
     if (!binFile) {
-        cerr << "Error saving binary data file" << endl;
+        logEvent(LogLevel::ERROR, "save_error", "Error saving binary data file", {}, background);
         return false;
     }
 
-    uint32_t version = 1;
+    uint32_t version = 2;
     binFile.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    uint64_t sequences[2] = {snap.getLastSequence(), snap.getResetSequence()};
+    binFile.write(reinterpret_cast<const char*>(sequences), sizeof(sequences));
 
-    size_t userCount = users.size();
+    size_t userCount = snapUsers.size();
     binFile.write(reinterpret_cast<const char*>(&userCount), sizeof(userCount));
 
-    for (const auto& user : users) {
-        size_t idLen = user.id.length();
-        binFile.write(reinterpret_cast<const char*>(&idLen), sizeof(idLen));
-        binFile.write(user.id.c_str(), idLen);
+    string id;
+    for (const auto& user : snapUsers) {
+        id.assign(user.text, user.idLength);
+        writeString(binFile, id);
+        writeString(binFile, user.name());
+        writeString(binFile, user.role());
+        writeString(binFile, status->at(id));
+        binFile.write(reinterpret_cast<const char*>(&user.sequence), sizeof(user.sequence));
+    }
 
-        size_t nameLen = user.name.length();
-        binFile.write(reinterpret_cast<const char*>(&nameLen), sizeof(nameLen));
-        binFile.write(user.name.c_str(), nameLen);
+    size_t logTotal = snap.getLogCount();
+    binFile.write(reinterpret_cast<const char*>(&logTotal), sizeof(logTotal));
 
-        size_t roleLen = user.role.length();
-        binFile.write(reinterpret_cast<const char*>(&roleLen), sizeof(roleLen));
-        binFile.write(user.role.c_str(), roleLen);
+    size_t index = 0;
+    snap.forEachLog([&](const LogRecord& log) {
+        writeString(binFile, log.userId());
+        writeString(binFile, log.userName());
+        writeString(binFile, log.action());
+        binFile.write(reinterpret_cast<const char*>(&log.timestamp), sizeof(log.timestamp));
+        uint64_t sequence = snap.getLogSequence(index++);
+        binFile.write(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+    });
 
-        string status = userStatus.at(user.id);
-        size_t statusLen = status.length();
-        binFile.write(reinterpret_cast<const char*>(&statusLen), sizeof(statusLen));
-        binFile.write(status.c_str(), statusLen);
+    streamoff bytes = binFile.tellp();
+    binFile.close();
+    if (!binFile || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        logEvent(LogLevel::ERROR, "save_error", "Error writing binary data file", {}, background);
+        return false;
     }
+    rebaseStatus(snap, status);
+    Metrics::instance().increment(MetricCounter::BYTES_WRITTEN, bytes);
+    Metrics::instance().setGauge(MetricGauge::DATA_FILE_BYTES, bytes, dataRoot);
+    updateGauges();
+    logEvent(LogLevel::INFO, "save",
+             "Binary data saved: " + to_string(snapUsers.size()) + " users, " +
+             to_string(logTotal) + " logs", {}, background);
+    return true;
+}
 
-    size_t logCount = dailyLogs.size();
-    binFile.write(reinterpret_cast<const char*>(&logCount), sizeof(logCount));
-
-    for (const auto& log : dailyLogs) {
-        size_t userIdLen = log.userId.length();
-        binFile.write(reinterpret_cast<const char*>(&userIdLen), sizeof(userIdLen));
-        binFile.write(log.userId.c_str(), userIdLen);
+// Every user or log entry takes at least this much of the file, which keeps
+// a corrupt count from reserving more than the file could hold.
+static const size_t MIN_ENTRY_BYTES = 4 * sizeof(size_t);
+
+struct LogHistory {
+    vector<shared_ptr<LogSegment>> segments;
+    size_t unsortedFrom;
+    time_t lastTimestamp;
+
+    LogHistory() : unsortedFrom(SIZE_MAX), lastTimestamp(0) {}
+};
+
+// Version 1 files carry no sequence numbers; their logs are numbered from
+// implicitSequence on. For version 2 files implicitSequence is 0 and the
+// stored numbers must keep growing, or the file is rejected.
+static bool readLogSection(ChunkReader& file, size_t count, uint64_t implicitSequence, LogHistory& history) {
+    size_t expectedLogs = min(count, file.getRemaining() / MIN_ENTRY_BYTES);
+    history.segments.reserve((expectedLogs + LogSegment::CAPACITY - 1) / LogSegment::CAPACITY);
+
+    string id, name, action;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < count && file.good(); ++i) {
+        file.readString(id);
+        file.readString(name);
+        file.readString(action);
+        time_t timestamp = 0;
+        file.read(&timestamp, sizeof(timestamp));
+        uint64_t sequence = implicitSequence + i;
+        if (implicitSequence == 0) {
+            file.read(&sequence, sizeof(sequence));
+        }
 
-        size_t userNameLen = log.userName.length();
-        binFile.write(reinterpret_cast<const char*>(&userNameLen), sizeof(userNameLen));
-        binFile.write(log.userName.c_str(), userNameLen);
+        if (i % LogSegment::CAPACITY == 0) {
+            history.segments.push_back(make_shared<LogSegment>(sequence));
+        }
+        LogSegment& segment = *history.segments.back();
+        if (sequence <= previous || sequence - segment.firstSequence > UINT32_MAX) {
+            return false;
+        }
+        previous = sequence;
 
-        size_t actionLen = log.action.length();
-        binFile.write(reinterpret_cast<const char*>(&actionLen), sizeof(actionLen));
-        binFile.write(log.action.c_str(), actionLen);
+        segment.entries[i % LogSegment::CAPACITY] =
+            LogRecord(segment.strings, id, name, action, timestamp,
+                      static_cast<uint32_t>(sequence - segment.firstSequence));
 
-        binFile.write(reinterpret_cast<const char*>(&log.timestamp), sizeof(log.timestamp));
+        if (i > 0 && timestamp < history.lastTimestamp && history.unsortedFrom == SIZE_MAX) {
+            history.unsortedFrom = i;
+        }
+        history.lastTimestamp = max(history.lastTimestamp, timestamp);
+        segment.count.store(i % LogSegment::CAPACITY + 1, memory_order_relaxed);
     }
-
-    binFile.close();
-    cout << "Binary data saved: " << users.size() << " users, " << dailyLogs.size() << " logs" << endl;
-    return true;
+    return file.good();
 }
 
 bool RFIDSystem::loadSystemData() {
-    ifstream file("data/system_data.bin", ios::binary);
-    if (!file) {
+    ScopedTimer timer(MetricOp::LOAD);
+    waitForHistory();
+    if (!loadData(false)) {
         return false;
     }
+    lock_guard<mutex> lock(writeMutex);
+    seedDetectorLocked();
+    return true;
+}
 
-    users.clear();
-    dailyLogs.clear();
-    userStatus.clear();
-
-    uint32_t version;
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    if (version != 1) {
-        cerr << "Unsupported file version: " << version << endl;
-        file.close();
+// Reads the users and their stored status, then either the logs too or,
+// with lazyHistory, hands the rest of the file to a background loader and
+// returns as soon as scans can be accepted.
+bool RFIDSystem::loadData(bool lazyHistory) {
+    shared_ptr<ChunkReader> file = make_shared<ChunkReader>(dataPath("system_data.bin").c_str());
+    if (!file->isOpen()) {
         return false;
     }
 
-    size_t userCount;
-    file.read(reinterpret_cast<char*>(&userCount), sizeof(userCount));
+    uint32_t version = 0;
+    file->read(&version, sizeof(version));
+    if (version != 1 && version != 2) {
+        logEvent(LogLevel::ERROR, "load_error",
+                 "Unsupported file version: " + to_string(version));
+        return false;
+    }
+    // version 2 adds the change-feed sequence numbers
+    uint64_t storedSequences[2] = {0, 0}; // last handed out, last reset
+    if (version == 2) {
+        file->read(storedSequences, sizeof(storedSequences));
+    }
 
-    for (size_t i = 0; i < userCount; ++i) {
-        User user;
-        string status;
+    // build the new state off to the side; scans keep running on the old one
+    shared_ptr<StringPool> loadedStrings;
+    {
+        lock_guard<mutex> lock(writeMutex);
+        loadedStrings = sharedDirectory ? userStrings : make_shared<StringPool>(false);
+    }
+    shared_ptr<vector<UserRecord>> loadedUsers = make_shared<vector<UserRecord>>();
+    StatusMap loadedStatus;
+    vector<bool> loadedInside;
+    string id, name, role, status;
+
+    size_t userCount = 0;
+    file->read(&userCount, sizeof(userCount));
+
+    // the header counts size the tables up front; strings go into one block
+    // sized for typical ids and names, and the arena grows if that is short
+    size_t expectedUsers = min(userCount, file->getRemaining() / MIN_ENTRY_BYTES);
+    loadedUsers->reserve(expectedUsers);
+    loadedInside.reserve(expectedUsers);
+    loadedStrings->reserve(expectedUsers * 32);
+
+    bool ordered = true;
+    for (size_t i = 0; i < userCount && file->good(); ++i) {
+        file->readString(id);
+        file->readString(name);
+        file->readString(role);
+        file->readString(status);
+        uint64_t sequence = i + 1;
+        if (version == 2) {
+            file->read(&sequence, sizeof(sequence));
+            ordered = ordered && (loadedUsers->empty() || sequence > loadedUsers->back().sequence);
+        }
 
-        size_t idLen;
-        file.read(reinterpret_cast<char*>(&idLen), sizeof(idLen));
-        user.id.resize(idLen);
-        file.read(&user.id[0], idLen);
+        loadedUsers->push_back(UserRecord(*loadedStrings, id, name, role, parseUserRole(role), sequence));
+        loadedInside.push_back(status != "OUT");
+        loadedStatus[id].swap(status);
+    }
 
-        size_t nameLen;
-        file.read(reinterpret_cast<char*>(&nameLen), sizeof(nameLen));
-        user.name.resize(nameLen);
-        file.read(&user.name[0], nameLen);
+    size_t loadedCount = 0;
+    file->read(&loadedCount, sizeof(loadedCount));
+    uint64_t implicitSequence = 0;
+    if (version == 1) {
+        implicitSequence = userCount + 1;
+        storedSequences[0] = userCount + loadedCount;
+    }
 
-        size_t roleLen;
-        file.read(reinterpret_cast<char*>(&roleLen), sizeof(roleLen));
-        user.role.resize(roleLen);
-        file.read(&user.role[0], roleLen);
+    LogHistory history;
+    if (!file->good() || !ordered ||
+        (!lazyHistory && !readLogSection(*file, loadedCount, implicitSequence, history))) {
+        logEvent(LogLevel::ERROR, "load_error",
+                 "Data file is truncated or corrupt, keeping current data");
+        return false;
+    }
+    if (!lazyHistory) {
+        Metrics::instance().setGauge(MetricGauge::DATA_FILE_BYTES, file->getOffset(), dataRoot);
+    }
 
-        size_t statusLen;
-        file.read(reinterpret_cast<char*>(&statusLen), sizeof(statusLen));
-        status.resize(statusLen);
-        file.read(&status[0], statusLen);
+    // the stored status already reflects every stored log; the snapshots
+    // read it from here and the writer only keeps userInside
+    shared_ptr<const StatusMap> storedStatus = make_shared<const StatusMap>(move(loadedStatus));
+    {
+        lock_guard<mutex> lock(writeMutex);
+        users = loadedUsers;
+        userStrings = loadedStrings;
+        segments.swap(history.segments);
+        lastTimestamp = history.lastTimestamp;
+        unsortedFrom = history.unsortedFrom;
+        baseStatus = storedStatus;
+        userInside.swap(loadedInside);
+        uint64_t previous = lastSequence;
+        lastSequence = max(lastSequence, storedSequences[0]);
+        resetSequence = storedSequences[1];
+        if (previous > storedSequences[0]) {
+            resetFeedLocked(); // changes made since the file was saved are gone
+        }
+        if (lazyHistory) {
+            // until the history arrives only new scans are held, on top of
+            // the stored status
+            logCount = 0;
+            baseLogCount = 0;
+            historyPending = true;
+            pendingHistoryCount = loadedCount;
+        } else {
+            logCount = loadedCount;
+            baseLogCount = loadedCount;
+        }
+        ++generation;
+        publishLocked();
+    }
 
-        users.push_back(user);
-        userStatus[user.id] = status;
+    updateGauges();
+    if (lazyHistory) {
+        logEvent(LogLevel::INFO, "load",
+                 "System data loaded: " + to_string(userCount) + " users, " +
+                 to_string(loadedCount) + " logs loading in background");
+        historyLoader = thread(&RFIDSystem::loadHistory, this, file, loadedCount, implicitSequence, storedStatus);
+    } else {
+        logEvent(LogLevel::INFO, "load",
+                 "System data loaded: " + to_string(userCount) + " users, " +
+                 to_string(loadedCount) + " logs");
     }
+    return true;
+}
 
-    size_t logCount;
-    file.read(reinterpret_cast<char*>(&logCount), sizeof(logCount));
+// Background half of a lazy load: reads the stored logs and splices them in
+// ahead of the scans taken since startup.
+void RFIDSystem::loadHistory(shared_ptr<ChunkReader> file, size_t count, uint64_t implicitSequence,
+                             shared_ptr<const StatusMap> status) {
+    auto start = chrono::steady_clock::now();
+    LogHistory history;
+    bool loaded = readLogSection(*file, count, implicitSequence, history);
+    size_t total;
+    {
+        lock_guard<mutex> lock(writeMutex);
+        if (loaded) {
+            vector<shared_ptr<LogSegment>> recent;
+            recent.swap(segments);
+            size_t recentCount = logCount;
+            segments.swap(history.segments);
+            logCount = count;
+            lastTimestamp = history.lastTimestamp;
+            unsortedFrom = history.unsortedFrom;
+            baseStatus = status;
+            baseLogCount = count;
+
+            // no epoch until the splice is done: a partial one would show
+            // the stored logs twice and the recent scans without their status
+            size_t remaining = recentCount;
+            for (const auto& segment : recent) {
+                size_t n = min(remaining, LogSegment::CAPACITY);
+                for (size_t i = 0; i < n; ++i) {
+                    const LogRecord& log = segment->entries[i];
+                    appendLogLocked(log.userId(), log.userName(), log.action(), log.timestamp,
+                                    segment->firstSequence + log.sequenceOffset);
+                }
+                remaining -= n;
+            }
+            ++generation;
+        }
+        historyPending = false;
+        pendingHistoryCount = 0;
+        total = logCount;
+        publishLocked();
+    }
+    historyReady.notify_all();
 
-    for (size_t i = 0; i < logCount; ++i) {
-        ScanLog log;
+    if (!loaded) {
+        // keep the scans taken so far; the stored logs are lost either way
+        logEvent(LogLevel::ERROR, "load_error",
+                 "Data file is truncated or corrupt, historical logs not loaded", {}, true);
+        return;
+    }
+    auto elapsed = chrono::steady_clock::now() - start;
+    auto micros = chrono::duration_cast<chrono::microseconds>(elapsed).count();
+    Metrics::instance().recordLatency(MetricOp::LOAD, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    Metrics::instance().setGauge(MetricGauge::DATA_FILE_BYTES, file->getOffset(), dataRoot);
+    Metrics::instance().setGauge(MetricGauge::HISTORY_LOAD_MICROS, micros, dataRoot);
+    updateGauges();
+    logEvent(LogLevel::INFO, "history_loaded",
+             "Historical logs loaded: " + to_string(count) + " logs in " +
+             to_string(micros / 1000) + " ms, " + to_string(total) + " in total", {}, true);
+}
 
-        size_t userIdLen;
-        file.read(reinterpret_cast<char*>(&userIdLen), sizeof(userIdLen));
-        log.userId.resize(userIdLen);
-        file.read(&log.userId[0], userIdLen);
+void RFIDSystem::waitForHistory() {
+    unique_lock<mutex> lock(writeMutex);
+    historyReady.wait(lock, [this] { return !historyPending; });
+}
 
-        size_t userNameLen;
-        file.read(reinterpret_cast<char*>(&userNameLen), sizeof(userNameLen));
-        log.userName.resize(userNameLen);
-        file.read(&log.userName[0], userNameLen);
+bool RFIDSystem::isHistoryLoaded() {
+    lock_guard<mutex> lock(writeMutex);
+    return !historyPending;
+}
 
-        size_t actionLen;
-        file.read(reinterpret_cast<char*>(&actionLen), sizeof(actionLen));
-        log.action.resize(actionLen);
-        file.read(&log.action[0], actionLen);
+// Called after a scan or user change. Rewriting the data file takes time
+// proportional to the whole history, so it is left to the saver thread and
+// the scan returns at once; changes made while a save runs are covered by
+// the next one.
+void RFIDSystem::persist() {
+    {
+        lock_guard<mutex> lock(saverMutex);
+        ++saveRequests;
+    }
+    saverWake.notify_one();
+}
 
-        file.read(reinterpret_cast<char*>(&log.timestamp), sizeof(log.timestamp));
+void RFIDSystem::saverLoop() {
+    unique_lock<mutex> lock(saverMutex);
+    while (true) {
+        saverWake.wait(lock, [this] { return saveRequests != savesDone || saverStopping; });
+        if (saveRequests == savesDone) {
+            return;
+        }
+        uint64_t covered = saveRequests;
+        lock.unlock();
+        saveChanges(); // waits for the history first if it is still loading
+        lock.lock();
+        savesDone = covered;
+        saverDone.notify_all();
+    }
+}
 
-        dailyLogs.push_back(log);
+// Saves the data file, refreshes the compact snapshot every
+// COMPACT_SNAPSHOT_INTERVAL changes and rewrites metrics.prom, so a scraper
+// sees current numbers without anyone opening the metrics page.
+void RFIDSystem::saveChanges() {
+    saveDataFile(true);
+
+    SystemSnapshot snap = snapshot();
+    uint64_t covered;
+    {
+        lock_guard<mutex> saveLock(saveMutex);
+        covered = snapshotSequence;
+    }
+    if (snap.getLastSequence() - covered >= COMPACT_SNAPSHOT_INTERVAL || covered < snap.getResetSequence()) {
+        saveSnapshotFile(true);
     }
+    writeMetrics();
+}
 
-    file.close();
-    cout << "System data loaded: " << users.size() << " users, " << dailyLogs.size() << " logs" << endl;
-    return true;
+void RFIDSystem::waitForSaves() {
+    unique_lock<mutex> lock(saverMutex);
+    uint64_t target = saveRequests;
+    saverDone.wait(lock, [&] { return savesDone >= target; });
 }
 
 bool RFIDSystem::saveAllData() {
     bool binarySuccess = saveSystemData();
     bool jsonSuccess = exportToJSON();
-    return binarySuccess && jsonSuccess;
+    bool snapshotSuccess = writeCompactSnapshot();
+    writeMetrics();
+    return binarySuccess && jsonSuccess && snapshotSuccess;
+}
+
+bool RFIDSystem::writeMetrics() {
+    // the saver thread writes it too; one writer at a time per temporary file
+    lock_guard<mutex> saveLock(saveMutex);
+    updateGauges();
+    return Metrics::instance().writeExposition(dataPath("metrics.prom"));
+}
+
+void RFIDSystem::updateGauges() {
+    SystemSnapshot snap = snapshot();
+    Metrics::instance().setGauge(MetricGauge::USERS, snap.getUsers().size(), dataRoot);
+    Metrics::instance().setGauge(MetricGauge::LOGS, snap.getLogCount(), dataRoot);
+}
+
+int RFIDSystem::getTotalScans() const {
+    SystemSnapshot snap = snapshot();
+    return snap.getLogCount() + snap.getPendingHistoryCount();
+}
+
+int RFIDSystem::getTotalUsers() const {
+    return snapshot().getUsers().size();
 }
 
 bool RFIDSystem::exportToJSON() {
-    ofstream jsonFile("data/system_data.json");
+    ScopedTimer timer(MetricOp::EXPORT);
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    const vector<UserRecord>& snapUsers = snap.getUsers();
+
+    ofstream jsonFile(dataPath("system_data.json"));
     if (!jsonFile) {
-        cerr << "Error creating JSON export file" << endl;
+        logEvent(LogLevel::ERROR, "export_error", "Error creating JSON export file");
         return false;
     }
 
     jsonFile << "{\n";
 
+    StatusMap status = snap.getStatusMap();
     jsonFile << "  \"users\": [\n";
-    for (size_t i = 0; i < users.size(); ++i) {
-        const auto& user = users[i];
+    for (size_t i = 0; i < snapUsers.size(); ++i) {
+        const auto& user = snapUsers[i];
         jsonFile << "    {\n";
-        jsonFile << "      \"id\": \"" << escapeJsonString(user.id) << "\",\n";
-        jsonFile << "      \"name\": \"" << escapeJsonString(user.name) << "\",\n";
-        jsonFile << "      \"role\": \"" << escapeJsonString(user.role) << "\",\n";
-        jsonFile << "      \"status\": \"" << escapeJsonString(userStatus.at(user.id)) << "\"\n";
+        jsonFile << "      \"id\": \"" << escapeJsonString(user.id()) << "\",\n";
+        jsonFile << "      \"name\": \"" << escapeJsonString(user.name()) << "\",\n";
+        jsonFile << "      \"role\": \"" << escapeJsonString(user.role()) << "\",\n";
+        jsonFile << "      \"status\": \"" << escapeJsonString(status.at(user.id().str())) << "\"\n";
         jsonFile << "    }";
-        if (i < users.size() - 1) jsonFile << ",";
+        if (i < snapUsers.size() - 1) jsonFile << ",";
         jsonFile << "\n";
     }
     jsonFile << "  ],\n";
 
     jsonFile << "  \"daily_logs\": [\n";
-    auto sortedLogs = getSortedLogs();
+    SortedLogView sortedLogs(snap);
+    char timestamp[TIMESTAMP_LENGTH];
     for (size_t i = 0; i < sortedLogs.size(); ++i) {
         const auto& log = sortedLogs[i];
+        formatTimestamp(log.timestamp, timestamp);
         jsonFile << "    {\n";
-        jsonFile << "      \"user_id\": \"" << escapeJsonString(log.userId) << "\",\n";
-        jsonFile << "      \"user_name\": \"" << escapeJsonString(log.userName) << "\",\n";
-        jsonFile << "      \"action\": \"" << escapeJsonString(log.action) << "\",\n";
-        jsonFile << "      \"timestamp\": \"" << log.getFormattedTime() << "\",\n";
+        jsonFile << "      \"user_id\": \"" << escapeJsonString(log.userId()) << "\",\n";
+        jsonFile << "      \"user_name\": \"" << escapeJsonString(log.userName()) << "\",\n";
+        jsonFile << "      \"action\": \"" << escapeJsonString(log.action()) << "\",\n";
+        jsonFile << "      \"timestamp\": \"";
+        jsonFile.write(timestamp, TIMESTAMP_LENGTH);
+        jsonFile << "\",\n";
         jsonFile << "      \"unix_timestamp\": " << log.timestamp << "\n";
         jsonFile << "    }";
         if (i < sortedLogs.size() - 1) jsonFile << ",";
@@ -270,134 +839,334 @@ bool RFIDSystem::exportToJSON() {
     jsonFile << "  ],\n";
 
     jsonFile << "  \"summary\": {\n";
-    jsonFile << "    \"total_users\": " << users.size() << ",\n";
-    jsonFile << "    \"total_scans\": " << dailyLogs.size() << ",\n";
+    jsonFile << "    \"total_users\": " << snapUsers.size() << ",\n";
+    jsonFile << "    \"total_scans\": " << snap.getLogCount() << ",\n";
+    jsonFile << "    \"last_sequence\": " << snap.getLastSequence() << ",\n";
     jsonFile << "    \"export_time\": \"" << getCurrentTimeString() << "\"\n";
     jsonFile << "  }\n";
     jsonFile << "}\n";
 
+    Metrics::instance().increment(MetricCounter::BYTES_WRITTEN, jsonFile.tellp());
     jsonFile.close();
-    cout << "JSON data exported: " << users.size() << " users, " << dailyLogs.size() << " logs" << endl;
+    logEvent(LogLevel::INFO, "export",
+             "JSON data exported: " + to_string(snapUsers.size()) + " users, " +
+             to_string(snap.getLogCount()) + " logs");
     return true;
 }
 
-string getCurrentTimeString() {
-    time_t now = time(nullptr);
-    stringstream ss;
-    ss << put_time(localtime(&now), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
-}
-
-string escapeJsonString(const string& input) {
-    string escaped;
-    for (char c : input) {
-        switch (c) {
-            case '"': escaped += "\\\""; break;
-            case '\\': escaped += "\\\\"; break;
-            case '\b': escaped += "\\b"; break;
-            case '\f': escaped += "\\f"; break;
-            case '\n': escaped += "\\n"; break;
-            case '\r': escaped += "\\r"; break;
-            case '\t': escaped += "\\t"; break;
-            default: escaped += c; break;
-        }
+// One JSON line per user; status is only given for state lines, since in
+// the change feed it follows from the scans.
+static void writeUserLine(ostream& out, const UserRecord& user, const string* status) {
+    out << "{\"seq\":" << user.sequence
+        << ",\"type\":\"user\",\"id\":\"" << escapeJsonString(user.id())
+        << "\",\"name\":\"" << escapeJsonString(user.name())
+        << "\",\"role\":\"" << escapeJsonString(user.role()) << "\"";
+    if (status) {
+        out << ",\"status\":\"" << escapeJsonString(*status) << "\"";
     }
-    return escaped;
+    out << "}\n";
 }
 
-void RFIDSystem::displayAllLogs() {
-    auto sortedLogs = getSortedLogs();
+void RFIDSystem::writeStateLines(ostream& out, const SystemSnapshot& snap, const StatusMap& status) {
+    for (const auto& user : snap.getUsers()) {
+        writeUserLine(out, user, &status.at(user.id().str()));
+    }
+}
 
-    cout << "\n=== ALL SCAN LOGS (Sorted by Time) ===\n";
-    cout << left << setw(12) << "User ID"
-              << setw(20) << "Name"
-              << setw(8) << "Action"
-              << "Timestamp\n";
-    cout << string(60, '-') << "\n";
+uint64_t RFIDSystem::exportChanges(uint64_t sinceSequence, ostream& out) {
+    ScopedTimer timer(MetricOp::EXPORT);
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    uint64_t last = snap.getLastSequence();
+
+    if (sinceSequence < snap.getResetSequence() || sinceSequence > last) {
+        out << "{\"seq\":" << last << ",\"type\":\"reset\"}\n";
+        writeStateLines(out, snap, snap.getStatusMap());
+        logEvent(LogLevel::INFO, "export_changes",
+                 "Change feed reset at sequence " + to_string(last) + ", sent full state",
+                 {{"since", to_string(sinceSequence)}, {"last", to_string(last)}});
+        return last;
+    }
 
-    for (const auto& log : sortedLogs) {
-        cout << left << setw(12) << log.userId
-                  << setw(20) << log.userName
-                  << setw(8) << log.action
-                  << log.getFormattedTime() << "\n";
+    // users and logs are each in sequence order; merge the two tails
+    const vector<UserRecord>& snapUsers = snap.getUsers();
+    auto user = upper_bound(snapUsers.begin(), snapUsers.end(), sinceSequence,
+                            [](uint64_t sequence, const UserRecord& record) { return sequence < record.sequence; });
+    size_t userChanges = snapUsers.end() - user;
+    size_t logIndex = snap.findLogAfter(sinceSequence);
+    size_t logEnd = snap.getLogCount();
+    size_t logChanges = logEnd - logIndex;
+
+    char timestamp[TIMESTAMP_LENGTH];
+    while (user != snapUsers.end() || logIndex < logEnd) {
+        uint64_t logSequence = logIndex < logEnd ? snap.getLogSequence(logIndex) : UINT64_MAX;
+        if (user != snapUsers.end() && user->sequence < logSequence) {
+            writeUserLine(out, *user, nullptr);
+            ++user;
+            continue;
+        }
+        const LogRecord& log = snap.getLog(logIndex++);
+        formatTimestamp(log.timestamp, timestamp);
+        out << "{\"seq\":" << logSequence
+            << ",\"type\":\"scan\",\"user_id\":\"" << escapeJsonString(log.userId())
+            << "\",\"user_name\":\"" << escapeJsonString(log.userName())
+            << "\",\"action\":\"" << escapeJsonString(log.action())
+            << "\",\"timestamp\":\"";
+        out.write(timestamp, TIMESTAMP_LENGTH);
+        out << "\",\"unix_timestamp\":" << log.timestamp << "}\n";
     }
-    cout << "\nTotal scans: " << sortedLogs.size() << "\n";
+
+    logEvent(LogLevel::INFO, "export_changes",
+             "Change feed exported: " + to_string(userChanges) + " users, " +
+             to_string(logChanges) + " scans after sequence " + to_string(sinceSequence),
+             {{"since", to_string(sinceSequence)}, {"last", to_string(last)}});
+    return last;
+}
+
+uint64_t RFIDSystem::getLastSequence() {
+    waitForHistory();
+    return snapshot().getLastSequence();
 }
 
-void RFIDSystem::displayAllUsers() {
-    cout << "\n=== ALL REGISTERED USERS ===\n";
-    cout << left << setw(12) << "User ID"
-              << setw(20) << "Name"
-              << setw(10) << "Role"
-              << "Registration\n";
-    cout << string(50, '-') << "\n";
+bool RFIDSystem::writeCompactSnapshot() {
+    return saveSnapshotFile(false);
+}
 
-    for (const auto& user : users) {
-        cout << left << setw(12) << user.id
-                  << setw(20) << user.name
-                  << setw(10) << user.role
-                  << "Active\n";
+bool RFIDSystem::saveSnapshotFile(bool background) {
+    ScopedTimer timer(MetricOp::EXPORT);
+    lock_guard<mutex> saveLock(saveMutex);
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    shared_ptr<const StatusMap> status = make_shared<const StatusMap>(snap.getStatusMap());
+    uint64_t last = snap.getLastSequence();
+
+    // write-then-rename so a consumer never reads a half-written snapshot
+    string path = dataPath("snapshot.jsonl");
+    string tmpPath = path + ".tmp";
+    streamoff bytes;
+    {
+        ofstream file(tmpPath);
+        if (!file) {
+            logEvent(LogLevel::ERROR, "export_error", "Error creating compact snapshot file", {}, background);
+            return false;
+        }
+        file << "{\"seq\":" << last << ",\"type\":\"snapshot\",\"total_users\":" << snap.getUsers().size()
+             << ",\"export_time\":\"" << getCurrentTimeString() << "\"}\n";
+        writeStateLines(file, snap, *status);
+        bytes = file.tellp();
+        if (!file) {
+            logEvent(LogLevel::ERROR, "export_error", "Error writing compact snapshot file", {}, background);
+            return false;
+        }
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        logEvent(LogLevel::ERROR, "export_error", "Error replacing compact snapshot file", {}, background);
+        return false;
     }
-    cout << "\nTotal users: " << users.size() << "\n";
+
+    snapshotSequence = last;
+    rebaseStatus(snap, status);
+    Metrics::instance().increment(MetricCounter::BYTES_WRITTEN, bytes);
+    logEvent(LogLevel::INFO, "snapshot",
+             "Compact snapshot written at sequence " + to_string(last) + ": " +
+             to_string(snap.getUsers().size()) + " users", {}, background);
+    return true;
 }
 
-void RFIDSystem::displayUserStatus() {
-    cout << "\n=== CURRENT USER STATUS ===\n";
-    cout << left << setw(12) << "User ID"
-              << setw(20) << "Name"
-              << setw(10) << "Role"
-              << "Status\n";
-    cout << string(50, '-') << "\n";
+string getCurrentTimeString() {
+    return formatTimestamp(time(nullptr));
+}
 
-    for (const auto& user : users) {
-        cout << left << setw(12) << user.id
-                  << setw(20) << user.name
-                  << setw(10) << user.role
-                  << userStatus[user.id] << "\n";
-    }
+// Clamps [offset, offset + limit) to the available rows.
+static void pageBounds(size_t total, size_t offset, size_t limit, size_t& begin, size_t& end) {
+    begin = min(offset, total);
+    end = begin + min(limit, total - begin);
 }
 
-void RFIDSystem::displayDailyReport() {
-    cout << "\n=== DAILY ATTENDANCE REPORT ===\n";
+static void pageFooter(TableRenderer& table, const char* label, size_t begin, size_t end, size_t total) {
+    if (begin == 0 && end == total) {
+        table.line(string("\nTotal ") + label + ": " + to_string(total) + "\n");
+    } else {
+        table.line("\nShowing " + to_string(total == 0 ? 0 : begin + 1) + "-" + to_string(end) +
+                   " of " + to_string(total) + " " + label + "\n");
+    }
+}
 
-    map<string, int> userScanCount;
-    map<string, string> lastAction;
+void RFIDSystem::displayAllLogs(size_t offset, size_t limit) {
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    SortedLogView logs(snap);
+    size_t begin, end;
+    pageBounds(logs.size(), offset, limit, begin, end);
+
+    TableRenderer table(cout, {{"User ID", 12}, {"Name", 20}, {"Action", 8}, {"Timestamp", 0}});
+    table.title("ALL SCAN LOGS (Sorted by Time)");
+    table.header(60);
+
+    char timestamp[TIMESTAMP_LENGTH];
+    for (size_t i = begin; i < end; ++i) {
+        const LogRecord& log = logs[i];
+        formatTimestamp(log.timestamp, timestamp);
+        table.cell(log.userId());
+        table.cell(log.userName());
+        table.cell(log.action());
+        table.cell(timestamp, TIMESTAMP_LENGTH);
+        table.endRow();
+    }
+    pageFooter(table, "scans", begin, end, logs.size());
+}
 
-    for (const auto& log : dailyLogs) {
-        userScanCount[log.userId]++;
-        lastAction[log.userId] = log.action;
+void RFIDSystem::displayAllUsers(size_t offset, size_t limit) {
+    SystemSnapshot snap = snapshot();
+    const vector<UserRecord>& snapUsers = snap.getUsers();
+    size_t begin, end;
+    pageBounds(snapUsers.size(), offset, limit, begin, end);
+
+    TableRenderer table(cout, {{"User ID", 12}, {"Name", 20}, {"Role", 10}, {"Registration", 0}});
+    table.title("ALL REGISTERED USERS");
+    table.header(50);
+
+    for (size_t i = begin; i < end; ++i) {
+        const UserRecord& user = snapUsers[i];
+        table.cell(user.id());
+        table.cell(user.name());
+        table.cell(user.role());
+        table.cell("Active", 6);
+        table.endRow();
     }
+    pageFooter(table, "users", begin, end, snapUsers.size());
+}
 
-    cout << left << setw(12) << "User ID"
-              << setw(20) << "Name"
-              << setw(12) << "Total Scans"
-              << "Last Action\n";
-    cout << string(60, '-') << "\n";
+void RFIDSystem::displayUserStatus(size_t offset, size_t limit) {
+    SystemSnapshot snap = snapshot();
+    const vector<UserRecord>& snapUsers = snap.getUsers();
+    size_t begin, end;
+    pageBounds(snapUsers.size(), offset, limit, begin, end);
+
+    TableRenderer table(cout, {{"User ID", 12}, {"Name", 20}, {"Role", 10}, {"Status", 0}});
+    table.title("CURRENT USER STATUS");
+    table.header(50);
+
+    for (size_t i = begin; i < end; ++i) {
+        const UserRecord& user = snapUsers[i];
+        table.cell(user.id());
+        table.cell(user.name());
+        table.cell(user.role());
+        table.cell(snap.getStatus(user.id().str()));
+        table.endRow();
+    }
+    if (begin != 0 || end != snapUsers.size()) {
+        pageFooter(table, "users", begin, end, snapUsers.size());
+    }
+}
 
-    for (const auto& user : users) {
-        int scans = userScanCount[user.id];
-        string action = lastAction[user.id].empty() ? "NONE" : lastAction[user.id];
+void RFIDSystem::displayDailyReport() {
+    waitForHistory();
+    SystemSnapshot snap = snapshot();
+    map<string, int> userScanCount;
+    map<string, string> lastAction;
 
-        cout << left << setw(12) << user.id
-                  << setw(20) << user.name
-                  << setw(12) << scans
-                  << action << "\n";
+    string key;
+    snap.forEachLog([&](const LogRecord& log) {
+        key.assign(log.text, log.idLength);
+        userScanCount[key]++;
+        lastAction[key] = log.action().str();
+    });
+
+    TableRenderer table(cout, {{"User ID", 12}, {"Name", 20}, {"Total Scans", 12}, {"Last Action", 0}});
+    table.title("DAILY ATTENDANCE REPORT");
+    table.header(60);
+
+    for (const auto& user : snap.getUsers()) {
+        key = user.id().str();
+        int scans = userScanCount[key];
+        const string& action = lastAction[key];
+
+        table.cell(user.id());
+        table.cell(user.name());
+        table.cell(scans);
+        table.cell(action.empty() ? string("NONE") : action);
+        table.endRow();
     }
 }
 
 void RFIDSystem::clearDailyLogs() {
-    dailyLogs.clear();
-    for (auto& status : userStatus) {
-        status.second = "OUT";
+    waitForHistory();
+    {
+        lock_guard<mutex> lock(writeMutex);
+        segments.clear();
+        logCount = 0;
+        lastTimestamp = 0;
+        unsortedFrom = SIZE_MAX;
+        userInside.assign(userInside.size(), false);
+        baseStatus = make_shared<const StatusMap>(); // users missing from it read as OUT
+        baseLogCount = 0;
+        ++generation;
+        resetFeedLocked();
+        seedDetectorLocked();
+        publishLocked();
     }
     saveSystemData();
-    cout << "Daily logs cleared and all users set to OUT status.\n";
+    writeCompactSnapshot();
+    logEvent(LogLevel::INFO, "clear_logs", "Daily logs cleared and all users set to OUT status.");
 }
 
 void RFIDSystem::clearAllData() {
-    users.clear();
-    dailyLogs.clear();
-    userStatus.clear();
+    waitForHistory();
+    {
+        lock_guard<mutex> lock(writeMutex);
+        users = make_shared<const vector<UserRecord>>();
+        if (!sharedDirectory) {
+            userStrings = make_shared<StringPool>();
+        }
+        segments.clear();
+        logCount = 0;
+        lastTimestamp = 0;
+        unsortedFrom = SIZE_MAX;
+        userInside.clear();
+        baseStatus = make_shared<const StatusMap>();
+        baseLogCount = 0;
+        ++generation;
+        resetFeedLocked();
+        seedDetectorLocked();
+        publishLocked();
+    }
     saveSystemData();
-    cout << "All system data cleared (users and logs).\n";
+    writeCompactSnapshot();
+    logEvent(LogLevel::INFO, "clear_all", "All system data cleared (users and logs).");
+}
+
+void RFIDSystem::displayMetrics() {
+    writeMetrics();
+    const Metrics& metrics = Metrics::instance();
+
+    cout << "\n=== SYSTEM METRICS ===\n";
+    cout << left << setw(10) << "Operation"
+              << setw(10) << "Count"
+              << setw(12) << "p50 (us)"
+              << setw(12) << "p99 (us)"
+              << "Max (us)\n";
+    cout << string(56, '-') << "\n";
+
+    const char* names[] = {"scan", "save", "load", "export"};
+    for (int op = 0; op < static_cast<int>(MetricOp::COUNT); ++op) {
+        LatencySummary s = metrics.getLatency(static_cast<MetricOp>(op));
+        cout << left << setw(10) << names[op]
+                  << setw(10) << s.count
+                  << setw(12) << s.p50Nanos / 1000
+                  << setw(12) << s.p99Nanos / 1000
+                  << s.maxNanos / 1000 << "\n";
+    }
+
+    cout << "\nScans: " << metrics.getCounter(MetricCounter::SCANS)
+         << ", Rejected: " << metrics.getCounter(MetricCounter::REJECTS)
+         << ", Denied: " << metrics.getCounter(MetricCounter::DENIALS)
+         << ", Alerts: " << metrics.getCounter(MetricCounter::ALERTS)
+         << ", Bytes written: " << metrics.getCounter(MetricCounter::BYTES_WRITTEN) << "\n";
+    cout << "Users: " << metrics.getGauge(MetricGauge::USERS, dataRoot)
+         << ", Log entries: " << metrics.getGauge(MetricGauge::LOGS, dataRoot)
+         << ", Data file: " << metrics.getGauge(MetricGauge::DATA_FILE_BYTES, dataRoot) << " bytes\n";
+    cout << "Time to first scan: " << metrics.getGauge(MetricGauge::TIME_TO_FIRST_SCAN_MICROS, dataRoot) / 1000.0
+         << " ms, history load: " << metrics.getGauge(MetricGauge::HISTORY_LOAD_MICROS, dataRoot) / 1000.0 << " ms\n";
+    cout << "Exposition file: " << dataPath("metrics.prom") << "\n";
 }
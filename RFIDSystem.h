@@ -3,25 +3,130 @@
 
 #include "User.h"
 #include "ScanLog.h"
+#include "AccessPolicy.h"
+#include "Snapshot.h"
+#include "AnomalyDetector.h"
+#include "Logger.h"
+#include <cstdint>
 #include <vector>
 #include <map>
+#include <memory>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <fstream>
+#include <ostream>
 
+class ChunkReader;
+
+// EAGER loads every historical log before the constructor returns.
+// LAZY_HISTORY loads the users and their current status, accepts scans right
+// away and reads the historical logs on a background thread; anything that
+// needs the full history waits for it.
+enum class StartupMode : uint8_t {
+    EAGER,
+    LAZY_HISTORY
+};
+
+// Writers (scans, user changes, loads) serialize on writeMutex and publish
+// a new Epoch only when the table shape changes; everything that only reads
+// works from a SystemSnapshot and never blocks a scan.
 class RFIDSystem {
 private:
-    std::vector<User> users;
-    std::vector<ScanLog> dailyLogs;
-    std::map<std::string, std::string> userStatus;
+    std::string dataRoot;
+
+    // writer state, guarded by writeMutex
+    std::shared_ptr<const std::vector<UserRecord>> users;
+    std::shared_ptr<StringPool> userStrings; // append-only, shared with published epochs
+    bool sharedDirectory; // userStrings belongs to a coordinator, never replaced
+    std::vector<std::shared_ptr<LogSegment>> segments;
+    size_t logCount;
+    std::time_t lastTimestamp;
+    size_t unsortedFrom;
+    uint64_t generation;
+    std::vector<bool> userInside; // by index into users: the card's last scan was IN
+    std::shared_ptr<const StatusMap> baseStatus;
+    size_t baseLogCount;
+    uint64_t lastSequence;  // last change-feed sequence number handed out
+    uint64_t resetSequence; // see Epoch::resetSequence
+    AccessPolicy accessPolicy;
+    bool policyLoaded; // accessPolicy holds a table compiled from the file
+    std::shared_ptr<AnomalyDetector> detector; // fed every accepted scan, under writeMutex
+    uint16_t door;
+
+    // background history load (LAZY_HISTORY), guarded by writeMutex
+    bool historyPending;
+    size_t pendingHistoryCount; // logs in the file still being loaded
+    std::condition_variable historyReady;
+    std::thread historyLoader;
+
+    // background saves requested by persist(), guarded by saverMutex
+    uint64_t saveRequests;
+    uint64_t savesDone; // requests covered by a finished save
+    bool saverStopping;
+    std::mutex saverMutex;
+    std::condition_variable saverWake;
+    std::condition_variable saverDone;
+    std::thread saver;
+
+    std::shared_ptr<const Epoch> epoch; // published; use atomic_load/atomic_store
+    std::mutex writeMutex;
+    std::mutex saveMutex;
+    uint64_t snapshotSequence; // covered by the last compact snapshot, guarded by saveMutex
+
+    // changes between compact snapshots written by persist()
+    static const uint64_t COMPACT_SNAPSHOT_INTERVAL = 1000;
+
     void createDataDirectory();
+    std::string dataPath(const char* file) const { return dataRoot + "/" + file; }
+    // Logs through the process-wide Logger with a "lab" field naming dataRoot,
+    // plus BACKGROUND_FIELD for events from the saver and history threads.
+    void logEvent(LogLevel level, const std::string& event, const std::string& message,
+                  std::vector<std::pair<std::string, std::string>> fields = {}, bool background = false);
+    void updateGauges();
+    void publishLocked();
+    bool appendLogLocked(StringRef userId, StringRef userName, StringRef action, std::time_t timestamp,
+                         uint64_t sequence);
+    void resetFeedLocked();
+    void seedDetectorLocked();
+    void writeStateLines(std::ostream& out, const SystemSnapshot& snap, const StatusMap& status);
+    void rebaseStatus(const SystemSnapshot& snap, const std::shared_ptr<const StatusMap>& status);
+    bool loadData(bool lazyHistory);
+    void loadHistory(std::shared_ptr<ChunkReader> file, size_t count, uint64_t implicitSequence,
+                     std::shared_ptr<const StatusMap> status);
+    bool saveDataFile(bool background);
+    bool saveSnapshotFile(bool background);
+    void persist();
+    void saverLoop();
+    void saveChanges();
 
 public:
-    RFIDSystem();
+    // All files live under dataRoot. A directory pool shared between systems
+    // stores user details registered in several of them once. Without a
+    // shared detector the system keeps its own, alerting to alerts.log, and
+    // is its door 0.
+    explicit RFIDSystem(const std::string& dataRoot = "data", StartupMode mode = StartupMode::LAZY_HISTORY,
+                        std::shared_ptr<StringPool> directory = nullptr,
+                        std::shared_ptr<AnomalyDetector> sharedDetector = nullptr, uint16_t detectorDoor = 0);
+    ~RFIDSystem();
+
+    // May not include historical logs yet; call waitForHistory() first
+    // when the full log is needed.
+    SystemSnapshot snapshot() const;
+    const std::string& getDataRoot() const { return dataRoot; }
+    void waitForHistory();
+    bool isHistoryLoaded();
+    // Scans and user changes are saved by a background thread; blocks until
+    // every change made so far is in the data file.
+    void waitForSaves();
 
     void addUser(const std::string& id, const std::string& name, const std::string& role);
-    User* findUser(const std::string& id);
+    // the pointer stays valid until the next user is added or data is cleared/loaded
+    const UserRecord* findUser(const std::string& id) const;
 
     bool scanRFID(const std::string& userId);
+    bool reloadAccessPolicy();
 
     std::vector<ScanLog> searchLogsByUserId(const std::string& userId);
     std::vector<ScanLog> getSortedLogs();
@@ -31,22 +136,36 @@ public:
     bool loadSystemData();
     bool saveAllData();
     bool exportToJSON();
+    bool writeMetrics();
+
+    // Change feed: every user registration and scan gets the next sequence
+    // number. Writes the changes after sinceSequence as JSON lines, in order,
+    // and returns the sequence to ask from next time. If the feed cannot go
+    // on from sinceSequence (data was cleared or reloaded since, or the caller
+    // is ahead), writes a reset line followed by the full current state.
+    uint64_t exportChanges(uint64_t sinceSequence, std::ostream& out);
+    // Current state only (users and their status, no history) as JSON lines
+    // in snapshot.jsonl; reading it and then exportChanges from its sequence
+    // catches a new consumer up.
+    bool writeCompactSnapshot();
+    uint64_t getLastSequence();
 
-    // display methods
-    void displayAllLogs();
-    void displayUserStatus();
+    // display methods, optionally limited to rows [offset, offset + limit)
+    void displayAllLogs(size_t offset = 0, size_t limit = SIZE_MAX);
+    void displayUserStatus(size_t offset = 0, size_t limit = SIZE_MAX);
     void displayDailyReport();
-    void displayAllUsers();
+    void displayAllUsers(size_t offset = 0, size_t limit = SIZE_MAX);
+    void displayMetrics();
 
     // maintenance methods
     void clearDailyLogs();
     void clearAllData();
-    int getTotalScans() const { return dailyLogs.size(); }
-    int getTotalUsers() const { return users.size(); }
+    int getTotalScans() const;
+    int getTotalUsers() const;
 };
 
 // Utility functions
 std::string getCurrentTimeString();
-std::string escapeJsonString(const std::string& input);
+bool createDirectories(const std::string& path); // each missing component of path
 
 #endif
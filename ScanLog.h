@@ -1,11 +1,11 @@
 #ifndef SCANLOG_H
 #define SCANLOG_H
 
+#include "Arena.h"
+#include "TimeFormat.h"
+#include <cstdint>
 #include <string>
 #include <ctime>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
 
 struct ScanLog {
     std::string userId;
@@ -20,9 +20,7 @@ struct ScanLog {
     }
 
     std::string getFormattedTime() const {
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&timestamp), "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+        return formatTimestamp(timestamp);
     }
 
     bool operator<(const ScanLog& other) const {
@@ -30,4 +28,45 @@ struct ScanLog {
     }
 };
 
+// Compact form of ScanLog held in the log segments, with the user id, user
+// name and action stored back to back in the segment's Arena. The change-feed
+// sequence number is kept relative to the segment's first entry, which fits
+// in the record's padding.
+struct LogRecord {
+    const char* text;
+    std::time_t timestamp;
+    uint32_t idLength;
+    uint32_t nameLength;
+    uint32_t actionLength;
+    uint32_t sequenceOffset;
+
+    LogRecord() : text(""), timestamp(0), idLength(0), nameLength(0), actionLength(0), sequenceOffset(0) {}
+    LogRecord(Arena& arena, StringRef uid, StringRef uname, StringRef act, std::time_t time, uint32_t offset)
+        : timestamp(time), idLength(uid.length), nameLength(uname.length), actionLength(act.length),
+          sequenceOffset(offset) {
+        char* out = arena.allocate(idLength + nameLength + actionLength);
+        std::memcpy(out, uid.data, idLength);
+        std::memcpy(out + idLength, uname.data, nameLength);
+        std::memcpy(out + idLength + nameLength, act.data, actionLength);
+        text = out;
+    }
+
+    StringRef userId() const { return StringRef(text, idLength); }
+    StringRef userName() const { return StringRef(text + idLength, nameLength); }
+    StringRef action() const { return StringRef(text + idLength + nameLength, actionLength); }
+
+    ScanLog toScanLog() const {
+        ScanLog log;
+        log.userId = userId().str();
+        log.userName = userName().str();
+        log.action = action().str();
+        log.timestamp = timestamp;
+        return log;
+    }
+
+    bool operator<(const LogRecord& other) const {
+        return timestamp < other.timestamp;
+    }
+};
+
 #endif
@@ -0,0 +1,107 @@
+#include "Snapshot.h"
+#include <algorithm>
+
+using namespace std;
+
+const size_t LogSegment::CAPACITY;
+const size_t LogSegment::ARENA_BLOCK_SIZE;
+
+SystemSnapshot::SystemSnapshot(shared_ptr<const Epoch> current)
+    : epoch(move(current)), logCount(0) {
+    if (!epoch->segments.empty()) {
+        logCount = (epoch->segments.size() - 1) * LogSegment::CAPACITY +
+                   epoch->segments.back()->count.load(memory_order_acquire);
+    }
+}
+
+StatusMap SystemSnapshot::getStatusMap() const {
+    StatusMap status;
+    if (epoch->baseStatus) {
+        status = *epoch->baseStatus;
+    }
+    string key; // reused so the replay does not allocate per log
+    for (size_t i = epoch->baseLogCount; i < logCount; ++i) {
+        const LogRecord& log = getLog(i);
+        key.assign(log.text, log.idLength);
+        StringRef action = log.action();
+        status[key].assign(action.data, action.length);
+    }
+    for (const auto& user : *epoch->users) {
+        status.insert(make_pair(user.id().str(), string("OUT")));
+    }
+    return status;
+}
+
+string SystemSnapshot::getStatus(const string& userId) const {
+    for (size_t i = logCount; i > epoch->baseLogCount; --i) {
+        const LogRecord& log = getLog(i - 1);
+        if (log.userId() == userId) {
+            return log.action().str();
+        }
+    }
+    if (epoch->baseStatus) {
+        auto it = epoch->baseStatus->find(userId);
+        if (it != epoch->baseStatus->end()) {
+            return it->second;
+        }
+    }
+    return "OUT";
+}
+
+const LogRecord* SystemSnapshot::findLastLog(const string& userId) const {
+    for (size_t i = logCount; i > 0; --i) {
+        const LogRecord& log = getLog(i - 1);
+        if (log.userId() == userId) {
+            return &log;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t SystemSnapshot::getLastSequence() const {
+    uint64_t last = epoch->resetSequence;
+    if (!epoch->users->empty()) {
+        last = max(last, epoch->users->back().sequence);
+    }
+    if (logCount > 0) {
+        last = max(last, getLogSequence(logCount - 1));
+    }
+    return last;
+}
+
+size_t SystemSnapshot::findLogAfter(uint64_t sequence) const {
+    size_t low = 0;
+    size_t high = logCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (getLogSequence(mid) <= sequence) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+vector<LogRecord> SystemSnapshot::getSortedRecords() const {
+    vector<LogRecord> records;
+    records.reserve(logCount);
+    forEachLog([&](const LogRecord& log) { records.push_back(log); });
+    if (!isSorted()) {
+        stable_sort(records.begin(), records.end());
+    }
+    return records;
+}
+
+vector<ScanLog> SystemSnapshot::getSortedLogs() const {
+    vector<ScanLog> logs;
+    logs.reserve(logCount);
+    if (isSorted()) {
+        forEachLog([&](const LogRecord& log) { logs.push_back(log.toScanLog()); });
+    } else {
+        for (const LogRecord& log : getSortedRecords()) {
+            logs.push_back(log.toScanLog());
+        }
+    }
+    return logs;
+}
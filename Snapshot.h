@@ -0,0 +1,113 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "User.h"
+#include "ScanLog.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::string> StatusMap;
+
+// Fixed-capacity block of scan logs. The writer fills slots in order and
+// then publishes them by bumping count, so entries below count never change
+// and readers can use them without locking. The strings of every entry live
+// in the segment's own arena and are freed with it.
+//
+// Sequence numbers grow along the log, so an entry's is firstSequence plus
+// its offset. Between two entries of a segment there are at most CAPACITY
+// scans and the user registrations in between, so offsets fit in 32 bits.
+struct LogSegment {
+    static const size_t CAPACITY = 4096;
+    static const size_t ARENA_BLOCK_SIZE = CAPACITY * 32; // ids + names of a typical segment
+
+    std::vector<LogRecord> entries; // sized to CAPACITY up front, never reallocated
+    Arena strings;
+    std::atomic<size_t> count;
+    uint64_t firstSequence; // set before the segment is published
+
+    explicit LogSegment(uint64_t sequence)
+        : entries(CAPACITY), strings(ARENA_BLOCK_SIZE), count(0), firstSequence(sequence) {}
+};
+
+// One published version of the system state. Everything reachable from an
+// epoch is immutable except the unpublished tail of the last segment, and
+// it is reclaimed when the last snapshot referencing it goes away.
+//
+// Per-user status is not copied on every scan: baseStatus holds the status
+// after the first baseLogCount logs and later logs are replayed on top.
+struct Epoch {
+    std::shared_ptr<const std::vector<UserRecord>> users;
+    std::shared_ptr<const StringPool> userStrings; // keeps the users' text alive
+    std::shared_ptr<const StatusMap> baseStatus;
+    size_t baseLogCount;
+    std::vector<std::shared_ptr<LogSegment>> segments; // all full except the last
+    size_t unsortedFrom; // first log index out of time order, or SIZE_MAX
+    uint64_t generation; // changes whenever the log history is replaced
+    size_t pendingHistory; // stored logs not loaded yet (lazy startup)
+    uint64_t resetSequence; // sequence of the last clear or reload; older changes are gone
+
+    Epoch() : baseLogCount(0), unsortedFrom(SIZE_MAX), generation(0), pendingHistory(0), resetSequence(0) {}
+};
+
+// Read-only view of one epoch, cheap to take and safe to keep while the
+// system keeps scanning.
+class SystemSnapshot {
+public:
+    SystemSnapshot(std::shared_ptr<const Epoch> epoch);
+
+    const std::vector<UserRecord>& getUsers() const { return *epoch->users; }
+    size_t getLogCount() const { return logCount; }
+    const LogRecord& getLog(size_t index) const {
+        return epoch->segments[index / LogSegment::CAPACITY]->entries[index % LogSegment::CAPACITY];
+    }
+    bool isSorted() const { return epoch->unsortedFrom >= logCount; }
+    uint64_t getGeneration() const { return epoch->generation; }
+    // Stored logs still loading in the background; they come before every
+    // log in this snapshot once loaded.
+    size_t getPendingHistoryCount() const { return epoch->pendingHistory; }
+
+    uint64_t getLogSequence(size_t index) const {
+        const LogSegment& segment = *epoch->segments[index / LogSegment::CAPACITY];
+        return segment.firstSequence + segment.entries[index % LogSegment::CAPACITY].sequenceOffset;
+    }
+    uint64_t getResetSequence() const { return epoch->resetSequence; }
+    // Highest sequence number of any change visible in this snapshot.
+    uint64_t getLastSequence() const;
+    // Index of the first log after sequence, or getLogCount() if none.
+    size_t findLogAfter(uint64_t sequence) const;
+
+    template <typename Fn>
+    void forEachLog(Fn fn) const {
+        size_t remaining = logCount;
+        for (const auto& segment : epoch->segments) {
+            size_t n = remaining < LogSegment::CAPACITY ? remaining : LogSegment::CAPACITY;
+            for (size_t i = 0; i < n; ++i) {
+                fn(segment->entries[i]);
+            }
+            remaining -= n;
+            if (remaining == 0) break;
+        }
+    }
+
+    // Status of every user ("IN"/"OUT") as of this snapshot.
+    StatusMap getStatusMap() const;
+    // Status of one user, replaying only the logs after the base.
+    std::string getStatus(const std::string& userId) const;
+    // Latest log of a user, searching backwards; nullptr if there is none.
+    const LogRecord* findLastLog(const std::string& userId) const;
+
+    // Logs in time order; a plain copy unless the clock went backwards. The
+    // records point into this snapshot's segments and must not outlive it.
+    std::vector<LogRecord> getSortedRecords() const;
+    std::vector<ScanLog> getSortedLogs() const;
+
+private:
+    std::shared_ptr<const Epoch> epoch;
+    size_t logCount;
+};
+
+#endif
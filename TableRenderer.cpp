@@ -0,0 +1,70 @@
+#include "TableRenderer.h"
+#include <cstdio>
+
+using namespace std;
+
+TableRenderer::TableRenderer(ostream& stream, const vector<TableColumn>& cols, size_t chunk)
+    : out(stream), columns(cols), chunkSize(chunk), column(0) {
+    buffer.reserve(chunkSize + 256);
+}
+
+TableRenderer::~TableRenderer() {
+    flush();
+}
+
+void TableRenderer::title(const string& text) {
+    append("\n=== ", 5);
+    append(text.data(), text.size());
+    append(" ===\n", 5);
+}
+
+void TableRenderer::header(size_t ruleWidth) {
+    for (const auto& col : columns) {
+        cell(col.title);
+    }
+    endRow();
+    buffer.append(ruleWidth, '-');
+    append("\n", 1);
+}
+
+void TableRenderer::cell(const char* text, size_t length) {
+    append(text, length);
+    if (column + 1 < columns.size()) {
+        size_t width = columns[column].width;
+        if (length < width) {
+            buffer.append(width - length, ' ');
+        }
+    }
+    ++column;
+}
+
+void TableRenderer::cell(long long value) {
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%lld", value);
+    cell(digits, static_cast<size_t>(length));
+}
+
+void TableRenderer::endRow() {
+    column = 0;
+    append("\n", 1);
+}
+
+void TableRenderer::line(const string& text) {
+    append(text.data(), text.size());
+}
+
+void TableRenderer::flush() {
+    if (!buffer.empty()) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    out.flush();
+}
+
+void TableRenderer::append(const char* text, size_t length) {
+    buffer.append(text, length);
+    if (buffer.size() >= chunkSize) {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
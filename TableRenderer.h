@@ -0,0 +1,44 @@
+#ifndef TABLERENDERER_H
+#define TABLERENDERER_H
+
+#include "Arena.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TableColumn {
+    std::string title;
+    size_t width; // minimum width; the last column is never padded
+};
+
+// Formats table rows into one reusable buffer and hands it to the stream
+// in large chunks instead of going through iostream manipulators per cell.
+class TableRenderer {
+public:
+    TableRenderer(std::ostream& out, const std::vector<TableColumn>& columns,
+                  size_t chunkSize = 64 * 1024);
+    ~TableRenderer();
+
+    void title(const std::string& text);
+    void header(size_t ruleWidth);
+
+    void cell(const char* text, size_t length);
+    void cell(StringRef text) { cell(text.data, text.length); }
+    void cell(long long value);
+    void endRow();
+
+    void line(const std::string& text); // free text, e.g. totals
+    void flush();
+
+private:
+    void append(const char* text, size_t length);
+
+    std::ostream& out;
+    std::vector<TableColumn> columns;
+    size_t chunkSize;
+    size_t column;
+    std::string buffer;
+};
+
+#endif
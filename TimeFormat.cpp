@@ -0,0 +1,113 @@
+#include "TimeFormat.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline void writeTwoDigits(char* out, int value) {
+    memcpy(out, &DIGIT_PAIRS[value * 2], 2);
+}
+
+// [start, end) is a span of local time with a fixed date and UTC offset;
+// secondsAtStart is the local second-of-day at start.
+struct DayCache {
+    time_t start;
+    time_t end;
+    long secondsAtStart;
+    int weekday; // 0 = Sunday
+    char date[10]; // "YYYY-MM-DD"
+
+    DayCache() : start(0), end(0), secondsAtStart(0), weekday(0) {}
+};
+
+thread_local DayCache cache;
+
+bool isLocalTime(time_t t, int yday, int hour, int min, int sec) {
+    tm local;
+    if (!localtime_r(&t, &local)) {
+        return false;
+    }
+    return local.tm_yday == yday && local.tm_hour == hour && local.tm_min == min && local.tm_sec == sec;
+}
+
+void refreshCache(time_t timestamp) {
+    tm local;
+    if (!localtime_r(&timestamp, &local)) {
+        memset(&local, 0, sizeof(local));
+    }
+
+    cache.weekday = local.tm_wday;
+    int year = local.tm_year + 1900;
+    writeTwoDigits(cache.date, (year / 100) % 100);
+    writeTwoDigits(cache.date + 2, year % 100);
+    cache.date[4] = '-';
+    writeTwoDigits(cache.date + 5, local.tm_mon + 1);
+    cache.date[7] = '-';
+    writeTwoDigits(cache.date + 8, local.tm_mday);
+
+    long secondOfDay = local.tm_hour * 3600L + local.tm_min * 60L + local.tm_sec;
+    time_t midnight = timestamp - secondOfDay;
+
+    if (isLocalTime(midnight, local.tm_yday, 0, 0, 0) &&
+        isLocalTime(midnight + 86399, local.tm_yday, 23, 59, 59)) {
+        cache.start = midnight;
+        cache.end = midnight + 86400;
+        cache.secondsAtStart = 0;
+    } else {
+        // the offset changes somewhere today; transitions fall on minute
+        // boundaries, so the current minute is always safe to reuse
+        cache.start = timestamp - local.tm_sec;
+        cache.end = cache.start + 60;
+        cache.secondsAtStart = local.tm_hour * 3600L + local.tm_min * 60L;
+    }
+}
+
+}
+
+void formatTimestamp(time_t timestamp, char* out) {
+    if (timestamp < cache.start || timestamp >= cache.end) {
+        refreshCache(timestamp);
+    }
+
+    long seconds = cache.secondsAtStart + static_cast<long>(timestamp - cache.start);
+    memcpy(out, cache.date, 10);
+    out[10] = ' ';
+    writeTwoDigits(out + 11, static_cast<int>(seconds / 3600));
+    out[13] = ':';
+    writeTwoDigits(out + 14, static_cast<int>((seconds / 60) % 60));
+    out[16] = ':';
+    writeTwoDigits(out + 17, static_cast<int>(seconds % 60));
+}
+
+void formatTimestamps(const time_t* timestamps, size_t count, char* out) {
+    for (size_t i = 0; i < count; ++i) {
+        formatTimestamp(timestamps[i], out + i * TIMESTAMP_LENGTH);
+    }
+}
+
+int localMinuteOfWeek(time_t timestamp) {
+    if (timestamp < cache.start || timestamp >= cache.end) {
+        refreshCache(timestamp);
+    }
+    long seconds = cache.secondsAtStart + static_cast<long>(timestamp - cache.start);
+    return cache.weekday * 1440 + static_cast<int>(seconds / 60);
+}
+
+string formatTimestamp(time_t timestamp) {
+    char buffer[TIMESTAMP_LENGTH];
+    formatTimestamp(timestamp, buffer);
+    return string(buffer, TIMESTAMP_LENGTH);
+}
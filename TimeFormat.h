@@ -0,0 +1,25 @@
+#ifndef TIMEFORMAT_H
+#define TIMEFORMAT_H
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+
+// Length of "YYYY-MM-DD HH:MM:SS"
+const size_t TIMESTAMP_LENGTH = 19;
+
+// Writes exactly TIMESTAMP_LENGTH characters (no terminator) of local time.
+// Each thread caches the local date of the day it last formatted, so only
+// the first timestamp of a day pays for localtime_r; the rest is digit
+// arithmetic. On days with a DST transition the cache narrows to a minute.
+void formatTimestamp(std::time_t timestamp, char* out);
+
+// Formats count timestamps back to back, TIMESTAMP_LENGTH bytes apart.
+void formatTimestamps(const std::time_t* timestamps, size_t count, char* out);
+
+std::string formatTimestamp(std::time_t timestamp);
+
+// Local minutes since Sunday 00:00, served from the same per-thread cache.
+int localMinuteOfWeek(std::time_t timestamp);
+
+#endif
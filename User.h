@@ -1,16 +1,79 @@
 #ifndef USER_H
 #define USER_H
 
+#include "Arena.h"
+#include <cstdint>
 #include <string>
 
+enum class UserRole : uint8_t {
+    STUDENT,
+    STAFF,
+    FACULTY,
+    OTHER,
+    COUNT
+};
+
+// Role names by UserRole, as written in user records and policy files.
+const char* const USER_ROLE_NAMES[] = {"student", "staff", "faculty", "other"};
+
+// Strict form for rule files: false unless text names a role exactly.
+inline bool parseUserRole(const std::string& text, UserRole& role) {
+    for (int r = 0; r < static_cast<int>(UserRole::COUNT); ++r) {
+        if (text == USER_ROLE_NAMES[r]) {
+            role = static_cast<UserRole>(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Users may carry any role text; anything unknown counts as OTHER.
+inline UserRole parseUserRole(const std::string& text) {
+    UserRole role = UserRole::OTHER;
+    parseUserRole(text, role);
+    return role;
+}
+
 struct User {
     std::string id;
     std::string name;
     std::string role; // student, staff, faculty
+    UserRole roleType; // parsed once so the scan path never compares strings
 
-    User() = default;
+    User() : roleType(UserRole::OTHER) {}
     User(const std::string& userId, const std::string& userName, const std::string& userRole)
-        : id(userId), name(userName), role(userRole) {}
+        : id(userId), name(userName), role(userRole), roleType(parseUserRole(userRole)) {}
+};
+
+// Compact form of User held in the system tables. The id, name and role are
+// stored back to back in a StringPool, so a record is a flat 32-byte value,
+// copying a table of them never touches the heap, and the same person
+// registered in several labs sharing a pool is stored once.
+struct UserRecord {
+    const char* text;
+    uint32_t idLength;
+    uint32_t nameLength;
+    uint32_t roleLength;
+    UserRole roleType;
+    uint64_t sequence; // change-feed sequence number of the registration
+
+    UserRecord() : text(""), idLength(0), nameLength(0), roleLength(0), roleType(UserRole::OTHER), sequence(0) {}
+    UserRecord(StringPool& pool, StringRef userId, StringRef userName, StringRef userRole, UserRole type,
+               uint64_t seq)
+        : idLength(userId.length), nameLength(userName.length), roleLength(userRole.length), roleType(type),
+          sequence(seq) {
+        thread_local std::string scratch;
+        scratch.assign(userId.data, idLength);
+        scratch.append(userName.data, nameLength);
+        scratch.append(userRole.data, roleLength);
+        text = pool.intern(scratch);
+    }
+
+    StringRef id() const { return StringRef(text, idLength); }
+    StringRef name() const { return StringRef(text + idLength, nameLength); }
+    StringRef role() const { return StringRef(text + idLength + nameLength, roleLength); }
+
+    User toUser() const { return User(id().str(), name().str(), role().str()); }
 };
 
 #endif
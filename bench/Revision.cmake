@@ -0,0 +1,21 @@
+# Run at build time by the rfid_bench_revision target: writes the source
+# revision to OUTPUT, touching it only when the revision changed so an
+# unchanged tree does not recompile the benchmark.
+execute_process(
+    COMMAND git describe --always --dirty
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE RFID_BENCH_REVISION
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET
+)
+if(NOT RFID_BENCH_REVISION)
+    set(RFID_BENCH_REVISION "unknown")
+endif()
+
+set(CONTENT "#define RFID_BENCH_REVISION \"${RFID_BENCH_REVISION}\"\n")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} PREVIOUS)
+endif()
+if(NOT "${CONTENT}" STREQUAL "${PREVIOUS}")
+    file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
@@ -0,0 +1,140 @@
+#include "WorkloadGenerator.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+namespace {
+
+const char* FIRST_NAMES[] = {
+    "James", "Mary", "Ahmad", "Siti", "Wei", "Priya", "John", "Fatimah", "Carlos", "Anna",
+    "Budi", "Dewi", "Kenji", "Olivia", "Rizky", "Maria", "David", "Aisyah", "Lucas", "Nur"
+};
+const char* LAST_NAMES[] = {
+    "Smith", "Santoso", "Wijaya", "Chen", "Garcia", "Kumar", "O'Brien", "Hidayat", "Tanaka",
+    "Nguyen", "Pratama", "Muller", "Rahman", "Silva", "Lestari", "Kim", "Johnson", "Saputra"
+};
+const size_t FIRST_NAME_COUNT = sizeof(FIRST_NAMES) / sizeof(FIRST_NAMES[0]);
+const size_t LAST_NAME_COUNT = sizeof(LAST_NAMES) / sizeof(LAST_NAMES[0]);
+
+void writeString(ofstream& out, const string& value) {
+    size_t len = value.length();
+    out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.write(value.data(), len);
+}
+
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& cfg)
+    : config(cfg), rng(cfg.seed) {
+    generateUsers();
+    if (config.scanSeed != 0) {
+        rng.seed(config.scanSeed); // same directory, different traffic
+    }
+    generateScans();
+}
+
+void WorkloadGenerator::generateUsers() {
+    users.reserve(config.userCount);
+    uniform_int_distribution<size_t> firstName(0, FIRST_NAME_COUNT - 1);
+    uniform_int_distribution<size_t> lastName(0, LAST_NAME_COUNT - 1);
+    uniform_real_distribution<double> roleDraw(0.0, 1.0);
+
+    char id[32];
+    for (size_t i = 0; i < config.userCount; ++i) {
+        double r = roleDraw(rng);
+        const char* role = r < 0.85 ? "student" : (r < 0.95 ? "staff" : "faculty");
+        const char* prefix = r < 0.85 ? "STU" : (r < 0.95 ? "STF" : "FAC");
+        snprintf(id, sizeof(id), "%s%07zu", prefix, i);
+        string name = string(FIRST_NAMES[firstName(rng)]) + " " + LAST_NAMES[lastName(rng)];
+        users.emplace_back(id, name, role);
+    }
+}
+
+time_t WorkloadGenerator::arrivalOffset() {
+    uniform_real_distribution<double> mix(0.0, 1.0);
+    double pick = mix(rng);
+    double seconds;
+    if (pick < config.nightShare) {
+        // an hour before midnight and six after it, kept clear of the 23:00 cap
+        uniform_real_distribution<double> night(-3600, 6 * 3600);
+        seconds = night(rng);
+        if (seconds < 0) {
+            seconds += 23 * 3600;
+        }
+    } else if (pick < config.nightShare + config.morningRushShare) {
+        normal_distribution<double> rush(8.5 * 3600, 20 * 60);
+        seconds = rush(rng);
+    } else if (pick < config.nightShare + config.morningRushShare + config.lunchShare) {
+        normal_distribution<double> lunch(13 * 3600, 30 * 60);
+        seconds = lunch(rng);
+    } else {
+        uniform_real_distribution<double> background(7 * 3600, 21 * 3600);
+        seconds = background(rng);
+    }
+    return static_cast<time_t>(max(0.0, min(seconds, 23.0 * 3600)));
+}
+
+void WorkloadGenerator::generateScans() {
+    uniform_real_distribution<double> attend(0.0, 1.0);
+    normal_distribution<double> dwell(4.0 * 3600, 1.5 * 3600);
+
+    size_t expected = static_cast<size_t>(config.userCount * config.dailyAttendance * config.days * 2);
+    scans.reserve(expected + expected / 8);
+
+    for (int day = 0; day < config.days; ++day) {
+        time_t dayStart = config.startDay + static_cast<time_t>(day) * 86400;
+        time_t dayEnd = dayStart + 86399;
+        for (size_t u = 0; u < users.size(); ++u) {
+            if (attend(rng) >= config.dailyAttendance) {
+                continue;
+            }
+            time_t in = dayStart + arrivalOffset();
+            time_t stay = static_cast<time_t>(max(600.0, dwell(rng)));
+            time_t out = min(in + stay, dayEnd);
+            scans.push_back({in, static_cast<uint32_t>(u), true});
+            scans.push_back({out, static_cast<uint32_t>(u), false});
+        }
+    }
+
+    stable_sort(scans.begin(), scans.end(), [](const SyntheticScan& a, const SyntheticScan& b) {
+        return a.timestamp < b.timestamp;
+    });
+}
+
+bool WorkloadGenerator::writeSystemData(const string& path) const {
+    ofstream out(path, ios::binary);
+    if (!out) {
+        return false;
+    }
+
+    vector<bool> inside(users.size(), false);
+    for (const auto& scan : scans) {
+        inside[scan.userIndex] = scan.in;
+    }
+
+    uint32_t version = 1;
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+
+    size_t userCount = users.size();
+    out.write(reinterpret_cast<const char*>(&userCount), sizeof(userCount));
+    for (size_t i = 0; i < users.size(); ++i) {
+        writeString(out, users[i].id);
+        writeString(out, users[i].name);
+        writeString(out, users[i].role);
+        writeString(out, inside[i] ? "IN" : "OUT");
+    }
+
+    size_t logCount = scans.size();
+    out.write(reinterpret_cast<const char*>(&logCount), sizeof(logCount));
+    for (const auto& scan : scans) {
+        const User& user = users[scan.userIndex];
+        writeString(out, user.id);
+        writeString(out, user.name);
+        writeString(out, scan.in ? "IN" : "OUT");
+        out.write(reinterpret_cast<const char*>(&scan.timestamp), sizeof(scan.timestamp));
+    }
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,56 @@
+#ifndef WORKLOADGENERATOR_H
+#define WORKLOADGENERATOR_H
+
+#include "User.h"
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+struct SyntheticScan {
+    std::time_t timestamp;
+    uint32_t userIndex;
+    bool in; // true for IN, false for OUT
+};
+
+struct WorkloadConfig {
+    size_t userCount = 1000;
+    int days = 1;
+    double dailyAttendance = 0.6;  // fraction of users who show up on a given day
+    double morningRushShare = 0.6; // arrivals clustered around 08:30
+    double lunchShare = 0.2;       // arrivals clustered around 13:00
+    double nightShare = 0.0;       // arrivals spread over 22:00-23:00 and 00:00-06:00
+    uint64_t seed = 42;
+    uint64_t scanSeed = 0; // separate seed for the scan stream; 0 continues from seed
+    std::time_t startDay = 1704067200; // 2024-01-01 00:00:00 UTC
+};
+
+// Deterministic synthetic data for benchmarks: a user directory with a
+// realistic role mix and a scan stream where each attending user taps IN on
+// arrival and OUT after a dwell period. Arrivals are a mixture of a tight
+// morning rush, a lunch-time wave, background traffic and optionally night
+// arrivals, so the stream has the bursts a real door sees at 08:00-09:00.
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& config);
+
+    const std::vector<User>& getUsers() const { return users; }
+    const std::vector<SyntheticScan>& getScans() const { return scans; }
+
+    // Writes users and scans in the RFIDSystem binary format (version 1)
+    // so large datasets can be loaded without going through addUser.
+    bool writeSystemData(const std::string& path) const;
+
+private:
+    void generateUsers();
+    void generateScans();
+    std::time_t arrivalOffset();
+
+    WorkloadConfig config;
+    std::mt19937_64 rng;
+    std::vector<User> users;
+    std::vector<SyntheticScan> scans;
+};
+
+#endif
@@ -0,0 +1,658 @@
+#include "RFIDSystem.h"
+#include "LabCoordinator.h"
+#include "AnomalyDetector.h"
+#include "Logger.h"
+#include "JsonEscape.h"
+#include "Metrics.h"
+#include "TimeFormat.h"
+#include "WorkloadGenerator.h"
+#include "BenchRevision.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+struct BenchOptions {
+    vector<size_t> userCounts = {1000, 10000, 100000};
+    int days = 5;
+    size_t iterations = 1000;     // cheap lookups
+    size_t heavyIterations = 5;   // whole-dataset operations
+    size_t scanIterations = 20;   // each scan rewrites the data file
+    uint64_t seed = 42;
+    string workdir = "rfid_bench_work";
+    string output = "bench_results.json";
+    bool keepData = false;
+    size_t labs = 0;              // also run the multi-lab coordinator with this many labs
+    int replayDays = 30;          // traffic replayed through the anomaly detector, 0 skips it
+};
+
+struct BenchResult {
+    string name;
+    size_t users;
+    size_t logs;
+    size_t iterations;
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double p99Ns;
+    double maxNs;
+};
+
+struct FootprintResult {
+    size_t users;
+    size_t logs;
+    double loadMs;      // eager load
+    long peakRssKb;
+    double firstScanMs; // lazy startup until scans are accepted
+    double historyMs;   // lazy startup until the historical logs are in
+};
+
+template <typename Fn>
+BenchResult measure(const string& name, size_t users, size_t logs, size_t iterations, Fn fn) {
+    vector<double> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; ++i) {
+        auto start = chrono::steady_clock::now();
+        fn(i);
+        auto end = chrono::steady_clock::now();
+        samples.push_back(chrono::duration<double, nano>(end - start).count());
+    }
+    sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.users = users;
+    result.logs = logs;
+    result.iterations = iterations;
+    if (samples.empty()) {
+        result.minNs = result.medianNs = result.meanNs = result.p99Ns = result.maxNs = 0;
+        return result;
+    }
+    double sum = 0;
+    for (double s : samples) sum += s;
+    result.minNs = samples.front();
+    result.medianNs = samples[samples.size() / 2];
+    result.meanNs = sum / samples.size();
+    result.p99Ns = samples[min(samples.size() - 1, static_cast<size_t>(samples.size() * 0.99))];
+    result.maxNs = samples.back();
+    return result;
+}
+
+vector<size_t> parseSizeList(const string& text) {
+    vector<size_t> sizes;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) {
+            sizes.push_back(static_cast<size_t>(strtoull(item.c_str(), nullptr, 10)));
+        }
+    }
+    return sizes;
+}
+
+void printUsage() {
+    cout << "Usage: rfid_bench [options]\n"
+         << "  --users N[,N...]     directory sizes (default 1000,10000,100000)\n"
+         << "  --days N             days of synthetic traffic per dataset (default 5)\n"
+         << "  --iters N            iterations for lookups (default 1000)\n"
+         << "  --heavy-iters N      iterations for save/load/export/sort (default 5)\n"
+         << "  --scan-iters N       iterations for scanRFID (default 20)\n"
+         << "  --seed N             workload seed (default 42)\n"
+         << "  --workdir DIR        scratch directory (default rfid_bench_work)\n"
+         << "  --out FILE           JSON results file (default bench_results.json)\n"
+         << "  --labs N             also host N lab shards sharing the directory (default off)\n"
+         << "  --replay-days N      days replayed through the anomaly detector (default 30, 0 skips)\n"
+         << "  --keep               keep generated datasets\n";
+}
+
+// Child side of runProbe: load the dataset in the current directory and
+// print the timings, in milliseconds, one per line. The load probe times
+// an eager load; the startup probe times a lazy startup until scans are
+// accepted and until the historical logs are in.
+int runLoadProbe(bool lazy) {
+    auto start = chrono::steady_clock::now();
+    RFIDSystem system("data", lazy ? StartupMode::LAZY_HISTORY : StartupMode::EAGER);
+    double readyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << fixed << setprecision(3) << readyMs << "\n";
+    if (lazy) {
+        system.waitForHistory();
+        cout << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << "\n";
+    }
+    cout << flush;
+    return 0;
+}
+
+// Runs a probe in a freshly exec'd copy of this binary, so its peak
+// resident set covers one startup load and not the generated workload held
+// by this process.
+bool runProbe(const char* flag, vector<double>& timings, long& peakRssKb) {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        execl("/proc/self/exe", "rfid_bench", flag, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(pipeFds[1]);
+    string output;
+    char buffer[64];
+    ssize_t n;
+    while ((n = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, n);
+    }
+    close(pipeFds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return false;
+    }
+    stringstream lines(output);
+    double value;
+    while (lines >> value) {
+        timings.push_back(value);
+    }
+    peakRssKb = usage.ru_maxrss;
+    return !timings.empty();
+}
+
+bool measureLoadFootprint(size_t users, size_t logs, FootprintResult& footprint) {
+    vector<double> eager, lazy;
+    long lazyPeakRssKb = 0;
+    if (!runProbe("--load-probe", eager, footprint.peakRssKb) ||
+        !runProbe("--startup-probe", lazy, lazyPeakRssKb) || lazy.size() < 2) {
+        return false;
+    }
+    footprint.users = users;
+    footprint.logs = logs;
+    footprint.loadMs = eager[0];
+    footprint.firstScanMs = lazy[0];
+    footprint.historyMs = lazy[1];
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--keep") {
+            options.keepData = true;
+        } else if (arg == "--load-probe") {
+            exit(runLoadProbe(false));
+        } else if (arg == "--startup-probe") {
+            exit(runLoadProbe(true));
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            exit(0);
+        } else if (!hasValue) {
+            cerr << "Missing value for " << arg << "\n";
+            return false;
+        } else if (arg == "--users") {
+            options.userCounts = parseSizeList(argv[++i]);
+        } else if (arg == "--days") {
+            options.days = atoi(argv[++i]);
+        } else if (arg == "--iters") {
+            options.iterations = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--heavy-iters") {
+            options.heavyIterations = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--scan-iters") {
+            options.scanIterations = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed") {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--workdir") {
+            options.workdir = argv[++i];
+        } else if (arg == "--out") {
+            options.output = argv[++i];
+        } else if (arg == "--labs") {
+            options.labs = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--replay-days") {
+            options.replayDays = atoi(argv[++i]);
+        } else {
+            cerr << "Unknown option " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void removeDataFiles(const string& dataDir) {
+    const char* files[] = {"system_data.bin", "system_data.json", "snapshot.jsonl", "changes.jsonl",
+                           "alerts.log", "metrics.prom"};
+    for (const char* file : files) {
+        unlink((dataDir + "/" + file).c_str());
+    }
+    rmdir(dataDir.c_str());
+}
+
+void removeDataset(const string& dir) {
+    removeDataFiles(dir + "/data");
+    rmdir(dir.c_str());
+}
+
+void runDataset(const BenchOptions& options, size_t userCount, vector<BenchResult>& results,
+                vector<FootprintResult>& footprints) {
+    WorkloadConfig config;
+    config.userCount = userCount;
+    config.days = options.days;
+    config.seed = options.seed;
+    WorkloadGenerator workload(config);
+
+    string dir = options.workdir + "/users_" + to_string(userCount);
+    mkdir(dir.c_str(), 0755);
+    mkdir((dir + "/data").c_str(), 0755);
+    if (!workload.writeSystemData(dir + "/data/system_data.bin")) {
+        cerr << "Failed to write dataset in " << dir << "\n";
+        return;
+    }
+
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd)) || chdir(dir.c_str()) != 0) {
+        cerr << "Cannot enter " << dir << "\n";
+        return;
+    }
+
+    FootprintResult footprint;
+    if (measureLoadFootprint(userCount, workload.getScans().size(), footprint)) {
+        footprints.push_back(footprint);
+    } else {
+        cerr << "Load footprint measurement failed for " << dir << "\n";
+    }
+
+    {
+        RFIDSystem system;
+        system.waitForHistory();
+        const vector<User>& users = workload.getUsers();
+        const vector<SyntheticScan>& scans = workload.getScans();
+        size_t logs = scans.size();
+
+        mt19937_64 rng(options.seed);
+        uniform_int_distribution<size_t> pickUser(0, users.size() - 1);
+        vector<size_t> lookups(options.iterations);
+        for (auto& index : lookups) index = pickUser(rng);
+
+        results.push_back(measure("findUser", userCount, logs, options.iterations, [&](size_t i) {
+            if (!system.findUser(users[lookups[i]].id)) abort();
+        }));
+        results.push_back(measure("searchLogsByUserId", userCount, logs, options.iterations, [&](size_t i) {
+            system.searchLogsByUserId(users[lookups[i]].id);
+        }));
+        results.push_back(measure("getSortedLogs", userCount, logs, options.heavyIterations, [&](size_t) {
+            system.getSortedLogs();
+        }));
+        results.push_back(measure("exportToJSON", userCount, logs, options.heavyIterations, [&](size_t) {
+            system.exportToJSON();
+        }));
+        results.push_back(measure("saveSystemData", userCount, logs, options.heavyIterations, [&](size_t) {
+            system.saveSystemData();
+        }));
+        results.push_back(measure("loadSystemData", userCount, logs, options.heavyIterations, [&](size_t) {
+            system.loadSystemData();
+        }));
+
+        // timestamp formatting for every log entry, against the previous
+        // stringstream + localtime + put_time path
+        vector<time_t> stamps;
+        stamps.reserve(scans.size());
+        for (const auto& scan : scans) stamps.push_back(scan.timestamp);
+        vector<char> formatted(stamps.size() * TIMESTAMP_LENGTH);
+        results.push_back(measure("formatTimestamps", userCount, logs, options.heavyIterations, [&](size_t) {
+            formatTimestamps(stamps.data(), stamps.size(), formatted.data());
+        }));
+        results.push_back(measure("formatTimestamps_putTime", userCount, logs, options.heavyIterations, [&](size_t) {
+            for (size_t i = 0; i < stamps.size(); ++i) {
+                stringstream ss;
+                ss << put_time(localtime(&stamps[i]), "%Y-%m-%d %H:%M:%S");
+                memcpy(&formatted[i * TIMESTAMP_LENGTH], ss.str().data(), TIMESTAMP_LENGTH);
+            }
+        }));
+
+        // replay the start of the synthetic stream (the morning rush)
+        uint64_t beforeScans = system.getLastSequence();
+        results.push_back(measure("scanRFID", userCount, logs, options.scanIterations, [&](size_t i) {
+            system.scanRFID(users[scans[i % scans.size()].userIndex].id);
+        }));
+        system.waitForSaves();
+
+        // the change feed for just those scans, against exportToJSON above
+        results.push_back(measure("exportChanges", userCount, logs, options.heavyIterations, [&](size_t) {
+            ofstream feed("data/changes.jsonl");
+            system.exportChanges(beforeScans, feed);
+        }));
+    }
+
+    if (chdir(cwd) != 0) {
+        cerr << "Cannot return to " << cwd << "\n";
+    }
+    if (!options.keepData) {
+        removeDataset(dir);
+    }
+}
+
+// Every lab registers the whole directory and sees its own share of the
+// traffic, so the shared pool should hold one copy of each user.
+void runLabs(const BenchOptions& options, size_t userCount, vector<BenchResult>& results) {
+    string dir = options.workdir + "/labs_" + to_string(userCount);
+    mkdir(dir.c_str(), 0755);
+
+    vector<User> users;
+    size_t logs = 0;
+    vector<string> labNames;
+    for (size_t lab = 0; lab < options.labs; ++lab) {
+        WorkloadConfig config;
+        config.userCount = userCount;
+        config.days = options.days;
+        config.seed = options.seed;
+        config.scanSeed = options.seed + 1 + lab;
+        config.dailyAttendance = 0.6 / options.labs;
+        WorkloadGenerator workload(config);
+
+        string name = "lab" + to_string(lab + 1);
+        string labDir = dir + "/" + name;
+        mkdir(labDir.c_str(), 0755);
+        if (!workload.writeSystemData(labDir + "/system_data.bin")) {
+            cerr << "Failed to write dataset in " << labDir << "\n";
+            return;
+        }
+        if (users.empty()) {
+            users = workload.getUsers();
+        }
+        logs += workload.getScans().size();
+        labNames.push_back(name);
+    }
+
+    {
+        LabCoordinator coordinator(dir, StartupMode::EAGER);
+        results.push_back(measure("labStartup", userCount, logs, 1, [&](size_t) {
+            for (const auto& name : labNames) coordinator.addLab(name);
+            for (const auto& name : labNames) coordinator.getLab(name);
+        }));
+
+        mt19937_64 rng(options.seed);
+        uniform_int_distribution<size_t> pickUser(0, users.size() - 1);
+        vector<size_t> lookups(options.iterations);
+        for (auto& index : lookups) index = pickUser(rng);
+
+        results.push_back(measure("locateUser", userCount, logs, options.iterations, [&](size_t i) {
+            coordinator.locateUser(users[lookups[i]].id);
+        }));
+        results.push_back(measure("buildingOccupancy", userCount, logs, options.heavyIterations, [&](size_t) {
+            coordinator.getOccupancy();
+        }));
+
+        size_t single = 0;
+        for (const auto& user : users) single += user.id.size() + user.name.size() + user.role.size();
+        cout << "  " << options.labs << " labs, directory pool: " << coordinator.getDirectory().getEntryCount()
+             << " entries, " << coordinator.getDirectory().getBytesUsed() / 1024 << " KiB (one copy: "
+             << single / 1024 << " KiB, unshared: " << single * options.labs / 1024 << " KiB)" << endl;
+    }
+
+    if (!options.keepData) {
+        for (const auto& name : labNames) {
+            removeDataFiles(dir + "/" + name);
+        }
+        unlink((dir + "/alerts.log").c_str());
+        rmdir(dir.c_str());
+    }
+}
+
+struct ReplayEvent {
+    time_t timestamp;
+    StringRef userId;
+    uint16_t door;
+    bool in;
+};
+
+// A month of synthetic traffic through the detector, one iteration per day,
+// fed by card id as RFIDSystem does. Users enter through a home door out of
+// REPLAY_DOORS and NIGHT_SHARE of the arrivals fall in the night window;
+// every CLONE_EVERY-th entry is followed by a cloned card entering at the
+// next door 5 s later and leaving after a minute, which should raise a door
+// hop and a double IN.
+void runAnomalyReplay(const BenchOptions& options, size_t userCount, vector<BenchResult>& results) {
+    const uint16_t REPLAY_DOORS = 4;
+    const size_t CLONE_EVERY = 1000;
+    const double NIGHT_SHARE = 0.01;
+
+    WorkloadConfig config;
+    config.userCount = userCount;
+    config.days = options.replayDays;
+    config.nightShare = NIGHT_SHARE;
+    config.seed = options.seed;
+    WorkloadGenerator workload(config);
+    const vector<SyntheticScan>& scans = workload.getScans();
+    const vector<User>& users = workload.getUsers();
+
+    vector<ReplayEvent> events;
+    events.reserve(scans.size() + 2 * (scans.size() / CLONE_EVERY + 1));
+    size_t entries = 0;
+    size_t clones = 0;
+    for (const auto& scan : scans) {
+        uint16_t door = static_cast<uint16_t>(scan.userIndex % REPLAY_DOORS);
+        StringRef userId(users[scan.userIndex].id);
+        events.push_back({scan.timestamp, userId, door, scan.in});
+        if (scan.in && ++entries % CLONE_EVERY == 0) {
+            uint16_t other = static_cast<uint16_t>((door + 1) % REPLAY_DOORS);
+            events.push_back({scan.timestamp + 5, userId, other, true});
+            events.push_back({scan.timestamp + 65, userId, other, false});
+            ++clones;
+        }
+    }
+    stable_sort(events.begin(), events.end(), [](const ReplayEvent& a, const ReplayEvent& b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    size_t peak = 0;
+    for (size_t i = 0, j = 0; i < events.size(); i = j) {
+        while (j < events.size() && events[j].timestamp == events[i].timestamp) ++j;
+        peak = max(peak, j - i);
+    }
+    vector<size_t> dayStart(options.replayDays + 1, events.size());
+    for (size_t i = events.size(); i-- > 0;) {
+        long day = (events[i].timestamp - config.startDay) / 86400;
+        if (day >= 0 && day < options.replayDays) dayStart[day] = i;
+    }
+    for (int day = options.replayDays - 1; day >= 0; --day) {
+        dayStart[day] = min(dayStart[day], dayStart[day + 1]);
+    }
+    dayStart[0] = 0;
+
+    string alertPath = options.workdir + "/alerts_" + to_string(userCount) + ".log";
+    {
+        AnomalyDetector detector(alertPath);
+        BenchResult result = measure("anomalyReplayDay", userCount, events.size(), options.replayDays,
+                                     [&](size_t day) {
+            for (size_t i = dayStart[day]; i < dayStart[day + 1]; ++i) {
+                const ReplayEvent& event = events[i];
+                detector.observe(event.userId, event.door, event.in, event.timestamp);
+            }
+        });
+        results.push_back(result);
+        detector.flush();
+
+        double totalMs = result.meanNs * options.replayDays / 1e6;
+        ios::fmtflags flags = cout.flags();
+        streamsize precision = cout.precision();
+        cout << "  " << options.replayDays << "-day replay: " << events.size() << " scans (" << clones
+             << " cloned) in " << fixed << setprecision(1) << totalMs << " ms, "
+             << setprecision(0) << events.size() / (totalMs / 1000) << " scans/s against a peak of "
+             << peak << " scans/s in the trace" << endl;
+        cout << "  alerts: door hop " << detector.getAlertCount(AnomalyKind::DOOR_HOP)
+             << ", double IN " << detector.getAlertCount(AnomalyKind::DOUBLE_IN)
+             << ", night " << detector.getAlertCount(AnomalyKind::NIGHT_ACCESS)
+             << ", burst " << detector.getAlertCount(AnomalyKind::SCAN_BURST)
+             << " (" << detector.getDroppedAlerts() << " dropped by the alert log)" << endl;
+        cout.flags(flags);
+        cout.precision(precision);
+    }
+    if (!options.keepData) {
+        unlink(alertPath.c_str());
+    }
+}
+
+// The cost of one recorded event: a latency sample plus a counter
+// increment, as a timed scan records them. A single event is below the
+// clock's resolution, so each iteration records a batch and the result is
+// scaled to one event.
+void runMetricsRecording(const BenchOptions& options, vector<BenchResult>& results) {
+    const size_t BATCH = 1000;
+
+    mt19937_64 rng(options.seed);
+    uniform_int_distribution<int> pickShift(8, 30);
+    vector<uint64_t> latencies(BATCH);
+    for (auto& nanos : latencies) nanos = (rng() & 0xff) << pickShift(rng);
+
+    Metrics& metrics = Metrics::instance();
+    BenchResult result = measure("metricsRecordEvent", 0, 0, options.iterations, [&](size_t) {
+        for (size_t i = 0; i < BATCH; ++i) {
+            metrics.recordLatency(MetricOp::SCAN, latencies[i]);
+            metrics.increment(MetricCounter::SCANS);
+        }
+    });
+    result.minNs /= BATCH;
+    result.medianNs /= BATCH;
+    result.meanNs /= BATCH;
+    result.p99Ns /= BATCH;
+    result.maxNs /= BATCH;
+    results.push_back(result);
+
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+    cout << "Metrics: " << fixed << setprecision(1) << result.medianNs << " ns per recorded event (median)" << endl;
+    cout.flags(flags);
+    cout.precision(precision);
+}
+
+bool writeResults(const BenchOptions& options, const vector<BenchResult>& results,
+                  const vector<FootprintResult>& footprints) {
+    ofstream out(options.output);
+    if (!out) {
+        return false;
+    }
+
+    out << fixed << setprecision(1);
+    out << "{\n";
+    out << "  \"suite\": \"rfid_bench\",\n";
+    out << "  \"format_version\": 2,\n";
+    out << "  \"revision\": \"" << escapeJsonString(RFID_BENCH_REVISION) << "\",\n";
+    out << "  \"compiler\": \"" << escapeJsonString(__VERSION__) << "\",\n";
+    out << "  \"timestamp\": \"" << getCurrentTimeString() << "\",\n";
+    out << "  \"config\": {\"days\": " << options.days << ", \"replay_days\": " << options.replayDays
+        << ", \"seed\": " << options.seed << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"users\": " << r.users
+            << ", \"logs\": " << r.logs << ", \"iterations\": " << r.iterations
+            << ", \"min_ns\": " << r.minNs << ", \"median_ns\": " << r.medianNs
+            << ", \"mean_ns\": " << r.meanNs << ", \"p99_ns\": " << r.p99Ns
+            << ", \"max_ns\": " << r.maxNs << "}";
+        if (i < results.size() - 1) out << ",";
+        out << "\n";
+    }
+    out << "  ],\n";
+    out << "  \"load_footprint\": [\n";
+    for (size_t i = 0; i < footprints.size(); ++i) {
+        const FootprintResult& f = footprints[i];
+        out << "    {\"users\": " << f.users << ", \"logs\": " << f.logs
+            << ", \"load_ms\": " << f.loadMs << ", \"peak_rss_kb\": " << f.peakRssKb
+            << ", \"first_scan_ms\": " << f.firstScanMs << ", \"history_ms\": " << f.historyMs << "}";
+        if (i < footprints.size() - 1) out << ",";
+        out << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    mkdir(options.workdir.c_str(), 0755);
+    Logger::instance().start(options.workdir + "/events.log");
+
+    vector<BenchResult> results;
+    vector<FootprintResult> footprints;
+    runMetricsRecording(options, results);
+    for (size_t userCount : options.userCounts) {
+        cout << "Running dataset with " << userCount << " users..." << endl;
+        runDataset(options, userCount, results, footprints);
+        if (options.labs > 0) {
+            runLabs(options, userCount, results);
+        }
+        if (options.replayDays > 0) {
+            runAnomalyReplay(options, userCount, results);
+        }
+    }
+    Logger::instance().stop();
+
+    cout << "\n" << left << setw(28) << "Benchmark"
+         << setw(10) << "Users"
+         << setw(10) << "Logs"
+         << setw(8) << "Iters"
+         << setw(16) << "Median (us)"
+         << "p99 (us)\n";
+    cout << string(82, '-') << "\n";
+    cout << fixed << setprecision(2);
+    for (const auto& r : results) {
+        cout << left << setw(28) << r.name
+             << setw(10) << r.users
+             << setw(10) << r.logs
+             << setw(8) << r.iterations
+             << setw(16) << r.medianNs / 1000
+             << r.p99Ns / 1000 << "\n";
+    }
+
+    cout << "\n" << left << setw(28) << "Startup"
+         << setw(10) << "Users"
+         << setw(10) << "Logs"
+         << setw(12) << "Load (ms)"
+         << setw(12) << "RSS (MiB)"
+         << setw(16) << "1st scan (ms)"
+         << "History (ms)\n";
+    cout << string(100, '-') << "\n";
+    for (const auto& f : footprints) {
+        cout << left << setw(28) << "RFIDSystem()"
+             << setw(10) << f.users
+             << setw(10) << f.logs
+             << setw(12) << f.loadMs
+             << setw(12) << f.peakRssKb / 1024.0
+             << setw(16) << f.firstScanMs
+             << f.historyMs << "\n";
+    }
+
+    if (!writeResults(options, results, footprints)) {
+        cerr << "Failed to write " << options.output << "\n";
+        return 1;
+    }
+    cout << "\nResults written to " << options.output << "\n";
+    return 0;
+}
@@ -1,8 +1,11 @@
 #include "RFIDSystem.h"
+#include "Logger.h"
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <fstream>
 #include <limits>
+#include <functional>
 
 using namespace std;
 
@@ -34,7 +37,9 @@ void displayAdminMenu() {
     cout << "9. Export to JSON\n";
     cout << "10. Clear Daily Logs\n";
     cout << "11. Clear All Data\n";
-    cout << "12. Logout to Main Menu\n";
+    cout << "12. Display Metrics\n";
+    cout << "13. Export Changes\n";
+    cout << "14. Logout to Main Menu\n";
     cout << "0. Exit System\n";
     cout << "================================\n";
     cout << "Enter your Choice: ";
@@ -49,6 +54,22 @@ void displayUserMenu() {
     cout << "Enter your Choice: ";
 }
 
+// Core events arrive on the logger's writer thread; errors go to stderr
+// like the rest of the diagnostics, everything else to the console except
+// background saves, which would land in the middle of a prompt.
+void renderEvent(const LogEvent& event) {
+    if (event.level == LogLevel::ERROR) {
+        cerr << event.message << "\n";
+    } else if (!event.hasField(BACKGROUND_FIELD)) {
+        cout << event.message << "\n";
+    }
+}
+
+// Wait for pending core events so they show up before our own output.
+void syncEvents() {
+    Logger::instance().flush();
+}
+
 string trim(const string& str) {
     size_t first = str.find_first_not_of(" \t\r\n");
     if (first == string::npos) return "";
@@ -201,6 +222,8 @@ void addUserInterface(RFIDSystem& system) {
 
     if (confirm == 'y' || confirm == 'Y') {
         system.addUser(id, name, role);
+        system.waitForSaves();
+        syncEvents();
         cout << "✓ Success: User successfully added and saved to system!\n";
     } else {
         cout << "User addition cancelled.\n";
@@ -218,9 +241,34 @@ void scanCardInterface(RFIDSystem& system) {
         cout << "Error: User ID cannot be empty.\n";
     } else {
         system.scanRFID(userId);
+        syncEvents();
     }
 }
 
+void exportChangesInterface(RFIDSystem& system) {
+    string input;
+    cout << "\n========== EXPORT CHANGES ==========\n";
+    cout << "Current sequence: " << system.getLastSequence() << "\n";
+    cout << "Export changes after sequence (0 for all): ";
+    getline(cin, input);
+    input = trim(input);
+
+    if (input.empty() || input.size() > 19 || input.find_first_not_of("0123456789") != string::npos) {
+        cout << "Error: Please enter a sequence number.\n";
+        return;
+    }
+
+    string path = system.getDataRoot() + "/changes.jsonl";
+    ofstream file(path);
+    if (!file) {
+        cout << "✗ Failed to create " << path << "\n";
+        return;
+    }
+    uint64_t next = system.exportChanges(stoull(input), file);
+    syncEvents();
+    cout << "✓ Changes written to " << path << ", export from " << next << " next time.\n";
+}
+
 void searchUserLogs(RFIDSystem& system) {
     string userId;
     cout << "\n========== SEARCH USER LOGS ==========\n";
@@ -248,6 +296,44 @@ void searchUserLogs(RFIDSystem& system) {
     }
 }
 
+const size_t PAGE_SIZE = 50;
+
+// Shows a listing one page at a time so large tables never flood the
+// terminal; only the rows of the current page are formatted.
+void browsePages(size_t total, bool startAtEnd, const function<void(size_t, size_t)>& showPage) {
+    size_t pages = total == 0 ? 1 : (total + PAGE_SIZE - 1) / PAGE_SIZE;
+    size_t page = startAtEnd ? pages - 1 : 0;
+
+    while (true) {
+        showPage(page * PAGE_SIZE, PAGE_SIZE);
+        if (pages == 1) {
+            return;
+        }
+
+        cout << "Page " << page + 1 << "/" << pages
+             << " - [Enter] next, [p] previous, [f] first, [l] last, [q] quit: ";
+        string command;
+        if (!getline(cin, command)) {
+            return;
+        }
+        command = trim(command);
+
+        if (command == "q" || command == "Q") {
+            return;
+        } else if (command == "p" || command == "P") {
+            if (page > 0) --page;
+        } else if (command == "f" || command == "F") {
+            page = 0;
+        } else if (command == "l" || command == "L") {
+            page = pages - 1;
+        } else if (page + 1 < pages) {
+            ++page;
+        } else {
+            return;
+        }
+    }
+}
+
 bool confirmAction(const string& message) {
     char confirm;
     cout << message << " (y/n): ";
@@ -270,13 +356,17 @@ bool confirmDangerousAction(const string& message, const string& confirmationTex
 
 void saveAndExit(RFIDSystem& system) {
     cout << "\nSaving system data before exit...\n";
-    if (system.saveAllData()) {
+    bool saved = system.saveAllData();
+    syncEvents();
+    if (saved) {
         cout << "✓ System data saved successfully!\n";
     } else {
         cout << "✗ Warning: Failed to save some system data!\n";
     }
 
-    if (system.exportToJSON()) {
+    bool exported = system.exportToJSON();
+    syncEvents();
+    if (exported) {
         cout << "✓ JSON export completed successfully!\n";
     } else {
         cout << "✗ Warning: Failed to export JSON data!\n";
@@ -288,7 +378,7 @@ void saveAndExit(RFIDSystem& system) {
 void runAdminMode(RFIDSystem& system) {
     while (true) {
         displayAdminMenu();
-        int choice = getValidIntInput(0, 12);
+        int choice = getValidIntInput(0, 14);
 
         switch (choice) {
             case 1:
@@ -304,11 +394,16 @@ void runAdminMode(RFIDSystem& system) {
                 break;
 
             case 4:
-                system.displayAllLogs();
+                // newest entries first, since that is what the admin usually wants
+                browsePages(system.getTotalScans(), true, [&](size_t offset, size_t limit) {
+                    system.displayAllLogs(offset, limit);
+                });
                 break;
 
             case 5:
-                system.displayUserStatus();
+                browsePages(system.getTotalUsers(), false, [&](size_t offset, size_t limit) {
+                    system.displayUserStatus(offset, limit);
+                });
                 break;
 
             case 6:
@@ -316,14 +411,18 @@ void runAdminMode(RFIDSystem& system) {
                 break;
 
             case 7:
-                system.displayAllUsers();
+                browsePages(system.getTotalUsers(), false, [&](size_t offset, size_t limit) {
+                    system.displayAllUsers(offset, limit);
+                });
                 break;
 
             case 8:
                 cout << "\nSaving system data...\n";
                 if (system.saveAllData()) {
+                    syncEvents();
                     cout << "✓ System data saved successfully!\n";
                 } else {
+                    syncEvents();
                     cout << "✗ Failed to save system data.\n";
                 }
                 break;
@@ -331,8 +430,10 @@ void runAdminMode(RFIDSystem& system) {
             case 9:
                 cout << "\nExporting system data to JSON...\n";
                 if (system.exportToJSON()) {
+                    syncEvents();
                     cout << "✓ System data exported successfully!\n";
                 } else {
+                    syncEvents();
                     cout << "✗ Failed to export system data.\n";
                 }
                 break;
@@ -340,6 +441,7 @@ void runAdminMode(RFIDSystem& system) {
             case 10:
                 if (confirmAction("\nWarning: This will clear all daily logs but keep users!\nAre you sure?")) {
                     system.clearDailyLogs();
+                    syncEvents();
                     cout << "✓ Daily logs cleared successfully!\n";
                 } else {
                     cout << "Operation cancelled.\n";
@@ -349,6 +451,7 @@ void runAdminMode(RFIDSystem& system) {
             case 11:
                 if (confirmDangerousAction("\nWARNING: This will delete ALL data (users and logs)!\nThis action cannot be undone. Are you absolutely sure?", "DELETE ALL")) {
                     system.clearAllData();
+                    syncEvents();
                     cout << "✓ All system data cleared successfully!\n";
                 } else {
                     cout << "Confirmation failed. Operation cancelled.\n";
@@ -356,6 +459,14 @@ void runAdminMode(RFIDSystem& system) {
                 break;
 
             case 12:
+                system.displayMetrics();
+                break;
+
+            case 13:
+                exportChangesInterface(system);
+                break;
+
+            case 14:
                 cout << "Logging out of admin panel...\n";
                 return; // Return to main menu
 
@@ -364,7 +475,7 @@ void runAdminMode(RFIDSystem& system) {
                 exit(0);
 
             default:
-                cout << "Error: Invalid option. Please choose a number between 0-12.\n";
+                cout << "Error: Invalid option. Please choose a number between 0-14.\n";
         }
 
         cout << "\nPress Enter to continue...";
@@ -406,6 +517,12 @@ void runUserMode(RFIDSystem& system) {
 int main() {
     RFIDSystem system;
 
+    Logger::instance().setSink(renderEvent);
+    if (!Logger::instance().start("data/events.log")) {
+        cerr << "Error opening event log, console output only\n";
+    }
+    syncEvents();
+
     cout << "========== RFID LAB SYSTEM ==========\n";
     cout << "Users: " << system.getTotalUsers() << ", Logs: " << system.getTotalScans() << "\n";
     cout << "=====================================\n";
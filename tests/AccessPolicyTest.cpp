@@ -0,0 +1,186 @@
+#include "AccessPolicy.h"
+#include "RFIDSystem.h"
+#include "Logger.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const int SLOTS_PER_DAY = 24 * 60 / AccessPolicy::SLOT_MINUTES;
+const char* POLICY_FILE = "policy_test.conf";
+
+enum Day { SUN, MON, TUE, WED, THU, FRI, SAT };
+
+int slotAt(Day day, int hours, int minutes) {
+    return day * SLOTS_PER_DAY + (hours * 60 + minutes) / AccessPolicy::SLOT_MINUTES;
+}
+
+void writeFile(const string& path, const string& text) {
+    ofstream file(path.c_str());
+    file << text;
+}
+
+bool load(AccessPolicy& policy, const string& text, string& error) {
+    writeFile(POLICY_FILE, text);
+    return policy.loadFromFile(POLICY_FILE, error);
+}
+
+void testWindowsAndRoles() {
+    AccessPolicy policy;
+    string error;
+    CHECK(load(policy,
+               "# role days from to\n"
+               "\n"
+               "student  mon-fri  08:00  22:00   # teaching hours\n"
+               "student  sat      10:00  14:00\n"
+               "faculty  *        00:00  24:00\n",
+               error));
+    CHECK_EQUAL(3u, policy.getRuleCount());
+
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(MON, 8, 0)));
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(FRI, 21, 45)));
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(MON, 7, 59)));
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(MON, 22, 0)));
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(SAT, 12, 0)));
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(SAT, 9, 0)));
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(SUN, 12, 0)));
+
+    CHECK(policy.allowsSlot(UserRole::FACULTY, slotAt(SUN, 0, 0)));
+    CHECK(policy.allowsSlot(UserRole::FACULTY, slotAt(SAT, 23, 45)));
+
+    // roles without a rule are not restricted
+    CHECK(policy.allowsSlot(UserRole::STAFF, slotAt(SUN, 3, 0)));
+    CHECK(policy.allowsSlot(UserRole::OTHER, slotAt(WED, 23, 0)));
+}
+
+// from > to runs past midnight into the next day, including from Saturday
+// into Sunday at the end of the week.
+void testWindowsPastMidnight() {
+    AccessPolicy policy;
+    string error;
+    CHECK(load(policy,
+               "staff  mon  22:00  06:00\n"
+               "other  sat  23:00  01:00\n",
+               error));
+
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(MON, 21, 45)));
+    CHECK(policy.allowsSlot(UserRole::STAFF, slotAt(MON, 22, 0)));
+    CHECK(policy.allowsSlot(UserRole::STAFF, slotAt(TUE, 0, 0)));
+    CHECK(policy.allowsSlot(UserRole::STAFF, slotAt(TUE, 5, 45)));
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(TUE, 6, 0)));
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(TUE, 22, 0)));
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(MON, 3, 0)));
+
+    CHECK(policy.allowsSlot(UserRole::OTHER, slotAt(SAT, 23, 30)));
+    CHECK(policy.allowsSlot(UserRole::OTHER, slotAt(SUN, 0, 45)));
+    CHECK(!policy.allowsSlot(UserRole::OTHER, slotAt(SUN, 1, 0)));
+    CHECK(!policy.allowsSlot(UserRole::OTHER, slotAt(SUN, 23, 30)));
+}
+
+// Window edges that fall inside a 15-minute slot round inwards, so a
+// partly covered slot never admits anyone outside the window.
+void testSlotRounding() {
+    AccessPolicy policy;
+    string error;
+    CHECK(load(policy, "student * 08:10 17:50\n", error));
+
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(WED, 8, 0)));  // 08:00-08:15
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(WED, 8, 15)));
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(WED, 17, 30))); // 17:30-17:45
+    CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(WED, 17, 45)));
+
+    // a window shorter than a slot admits no one
+    CHECK(load(policy, "staff * 09:05 09:10\n", error));
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(WED, 9, 0)));
+    CHECK(!policy.allowsSlot(UserRole::STAFF, slotAt(WED, 9, 15)));
+}
+
+// Any bad line rejects the whole file, names the line and leaves the
+// previously loaded table in force.
+void testBadLines() {
+    const char* badFiles[] = {
+        "student * 08:00\n",
+        "student * 08:00 22:00 extra\n",
+        "teacher * 08:00 22:00\n",
+        "student mon-xyz 08:00 22:00\n",
+        "student * 8:60 22:00\n",
+        "student * 08:00 24:30\n",
+        "student * 24:00 02:00\n",
+        "student * 08h00 22:00\n",
+    };
+
+    AccessPolicy policy;
+    string error;
+    CHECK(load(policy, "student mon-fri 08:00 22:00\n", error));
+
+    for (const char* text : badFiles) {
+        error.clear();
+        string file = string("# header\n") + text;
+        if (load(policy, file, error)) {
+            cerr << "accepted bad policy: " << text;
+            ++testFailures;
+        }
+        CHECK_EQUAL(0u, error.find("line 2: "));
+        CHECK_EQUAL(1u, policy.getRuleCount());
+        CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(MON, 12, 0)));
+        CHECK(!policy.allowsSlot(UserRole::STUDENT, slotAt(SUN, 12, 0)));
+    }
+
+    // a missing file means no rules at all
+    remove(POLICY_FILE);
+    CHECK(policy.loadFromFile(POLICY_FILE, error));
+    CHECK_EQUAL(0u, policy.getRuleCount());
+    CHECK(policy.allowsSlot(UserRole::STUDENT, slotAt(SUN, 12, 0)));
+}
+
+// A policy that fails to parse never lifts restrictions: a reload keeps the
+// rules in force, and a system starting with a bad file refuses entry.
+void testSystemKeepsPolicyOnError() {
+    const string dir = "policy_system";
+    removeData(dir);
+    createDirectories(dir);
+    const string path = dir + "/access_policy.conf";
+
+    // a window shorter than a slot, so students are never admitted
+    writeFile(path, "student * 09:05 09:10\n");
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        system.addUser("S1", "Sam", "student");
+        CHECK(!system.scanRFID("S1"));
+
+        writeFile(path, "student * 00:00 25:00\n");
+        CHECK(!system.reloadAccessPolicy());
+        CHECK(!system.scanRFID("S1"));
+
+        writeFile(path, "student * 00:00 24:00\n");
+        CHECK(system.reloadAccessPolicy());
+        CHECK(system.scanRFID("S1"));
+        system.waitForSaves();
+    }
+
+    writeFile(path, "student * 00:00 25:00\n");
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        CHECK(system.scanRFID("S1")); // leaving is never blocked
+        CHECK(!system.scanRFID("S1"));
+        CHECK_EQUAL(string("OUT"), system.snapshot().getStatus("S1"));
+    }
+    removeData(dir);
+}
+
+}
+
+int main() {
+    Logger::instance().setMinLevel(LogLevel::ERROR);
+    testWindowsAndRoles();
+    testWindowsPastMidnight();
+    testSlotRounding();
+    testBadLines();
+    testSystemKeepsPolicyOnError();
+    remove(POLICY_FILE);
+    return testResult("AccessPolicyTest");
+}
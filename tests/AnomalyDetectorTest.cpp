@@ -0,0 +1,166 @@
+#include "AnomalyDetector.h"
+#include "Logger.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const char* ALERT_LOG = "anomaly_test_alerts.log";
+
+const bool IN = true;
+const bool OUT = false;
+
+// A Monday in local time, so the night rule sees the hour given here.
+time_t localTime(int hours, int minutes) {
+    struct tm parts = {};
+    parts.tm_year = 2024 - 1900;
+    parts.tm_mon = 0;
+    parts.tm_mday = 15;
+    parts.tm_hour = hours;
+    parts.tm_min = minutes;
+    parts.tm_isdst = -1;
+    return mktime(&parts);
+}
+
+uint64_t alerts(const AnomalyDetector& detector, AnomalyKind kind) {
+    return detector.getAlertCount(kind);
+}
+
+// An IN at another door within doorHopSeconds of the last IN, whether or
+// not the card left in between; the same door or a later IN is fine.
+void testDoorHop() {
+    AnomalyDetector detector(ALERT_LOG);
+    time_t noon = localTime(12, 0);
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, IN, noon));
+    CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, OUT, noon + 5));
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 1, IN, noon + 20));
+    CHECK_EQUAL(1u, alerts(detector, AnomalyKind::DOOR_HOP));
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, IN, noon));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, OUT, noon + 5));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 1, IN, noon + 31));
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("C3"), 0, IN, noon));
+    CHECK_EQUAL(0u, detector.observe(StringRef("C3"), 0, OUT, noon + 5));
+    CHECK_EQUAL(0u, detector.observe(StringRef("C3"), 0, IN, noon + 10));
+
+    // still inside the first door as well: a hop and a double IN
+    CHECK_EQUAL(0u, detector.observe(StringRef("D4"), 0, IN, noon));
+    CHECK_EQUAL(2u, detector.observe(StringRef("D4"), 1, IN, noon + 5));
+    CHECK_EQUAL(2u, alerts(detector, AnomalyKind::DOOR_HOP));
+    CHECK_EQUAL(1u, alerts(detector, AnomalyKind::DOUBLE_IN));
+}
+
+// An IN while the card is still IN at another door, however long ago; an
+// OUT only counts at the door the card is inside.
+void testDoubleIn() {
+    AnomalyDetector detector(ALERT_LOG);
+    time_t noon = localTime(12, 0);
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, IN, noon));
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 1, IN, noon + 3600));
+    CHECK_EQUAL(1u, alerts(detector, AnomalyKind::DOUBLE_IN));
+    CHECK_EQUAL(0u, alerts(detector, AnomalyKind::DOOR_HOP));
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, IN, noon));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 1, OUT, noon + 600));
+    CHECK_EQUAL(1u, detector.observe(StringRef("B2"), 1, IN, noon + 1200));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 1, OUT, noon + 1800));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, OUT, noon + 2400));
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 1, IN, noon + 3000));
+    CHECK_EQUAL(2u, alerts(detector, AnomalyKind::DOUBLE_IN));
+}
+
+// INs from 22:00 up to but not including 06:00 local time; leaving at
+// night is not an alert.
+void testNightAccess() {
+    AnomalyDetector detector(ALERT_LOG);
+
+    CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, IN, localTime(21, 59)));
+    CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, OUT, localTime(22, 30)));
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 0, IN, localTime(22, 45)));
+    CHECK_EQUAL(1u, detector.observe(StringRef("B2"), 0, IN, localTime(0, 0)));
+    CHECK_EQUAL(1u, detector.observe(StringRef("C3"), 0, IN, localTime(5, 59)));
+    CHECK_EQUAL(0u, detector.observe(StringRef("D4"), 0, IN, localTime(6, 0)));
+    CHECK_EQUAL(0u, detector.observe(StringRef("E5"), 0, IN, localTime(12, 0)));
+    CHECK_EQUAL(3u, alerts(detector, AnomalyKind::NIGHT_ACCESS));
+
+    AnomalyRules rules;
+    rules.nightStartMinute = rules.nightEndMinute = 0;
+    AnomalyDetector disabled(ALERT_LOG, rules);
+    CHECK_EQUAL(0u, disabled.observe(StringRef("A1"), 0, IN, localTime(23, 0)));
+}
+
+// BURST_SCANS scans within burstSeconds raise one alert; the scans after
+// it stay quiet until a window made only of newer scans fills up again.
+void testScanBurst() {
+    AnomalyDetector detector(ALERT_LOG);
+    time_t noon = localTime(12, 0);
+
+    bool in = IN;
+    for (int i = 0; i < 4; ++i, in = !in) {
+        CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, in, noon + i * 10));
+    }
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 0, in, noon + 40));
+    in = !in;
+    for (int i = 5; i < 9; ++i, in = !in) {
+        CHECK_EQUAL(0u, detector.observe(StringRef("A1"), 0, in, noon + i * 10));
+    }
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 0, in, noon + 90));
+    CHECK_EQUAL(2u, alerts(detector, AnomalyKind::SCAN_BURST));
+
+    // five scans spread over more than burstSeconds
+    const int spread[] = {0, 15, 30, 45, 61};
+    in = IN;
+    for (int offset : spread) {
+        CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, in, noon + offset));
+        in = !in;
+    }
+    CHECK_EQUAL(2u, alerts(detector, AnomalyKind::SCAN_BURST));
+}
+
+// markInside seeds the inside door without raising anything, and
+// resetDoor forgets only the cards inside that door, so a re-seed after a
+// reset replaces the old state.
+void testSeeding() {
+    AnomalyDetector detector(ALERT_LOG);
+    time_t noon = localTime(12, 0);
+
+    detector.markInside(StringRef("A1"), 2);
+    CHECK_EQUAL(0u, alerts(detector, AnomalyKind::DOUBLE_IN));
+    CHECK_EQUAL(1u, detector.observe(StringRef("A1"), 0, IN, noon));
+
+    detector.markInside(StringRef("B2"), 2);
+    detector.markInside(StringRef("C3"), 1);
+    detector.markInside(StringRef("D4"), 2);
+    detector.resetDoor(2);
+    detector.markInside(StringRef("D4"), 3);
+    CHECK_EQUAL(0u, detector.observe(StringRef("B2"), 0, IN, noon));
+    CHECK_EQUAL(1u, detector.observe(StringRef("C3"), 0, IN, noon));
+    CHECK_EQUAL(1u, detector.observe(StringRef("D4"), 0, IN, noon));
+    CHECK_EQUAL(3u, alerts(detector, AnomalyKind::DOUBLE_IN));
+
+    // the seeded door is left normally
+    detector.markInside(StringRef("E5"), 1);
+    CHECK_EQUAL(0u, detector.observe(StringRef("E5"), 1, OUT, noon));
+    CHECK_EQUAL(0u, detector.observe(StringRef("E5"), 0, IN, noon + 60));
+    CHECK_EQUAL(0u, alerts(detector, AnomalyKind::DOOR_HOP));
+}
+
+}
+
+int main() {
+    Logger::instance().setMinLevel(LogLevel::ERROR);
+    testDoorHop();
+    testDoubleIn();
+    testNightAccess();
+    testScanBurst();
+    testSeeding();
+    remove(ALERT_LOG);
+    return testResult("AnomalyDetectorTest");
+}
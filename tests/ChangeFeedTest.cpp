@@ -0,0 +1,361 @@
+#include "RFIDSystem.h"
+#include "Logger.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Writes system_data.bin field by field, so tests can build files the
+// current code would never save (version 1, out-of-order sequences).
+class DataFileWriter {
+public:
+    DataFileWriter(const string& dir, uint32_t version) : file((dir + "/system_data.bin").c_str(), ios::binary) {
+        write(version);
+    }
+
+    void header(uint64_t lastSequence, uint64_t resetSequence) {
+        write(lastSequence);
+        write(resetSequence);
+    }
+    void count(size_t n) { write(n); }
+    void user(const string& id, const string& name, const string& role, const string& status) {
+        text(id);
+        text(name);
+        text(role);
+        text(status);
+    }
+    void log(const string& id, const string& name, const string& action, time_t timestamp) {
+        text(id);
+        text(name);
+        text(action);
+        write(timestamp);
+    }
+    void sequence(uint64_t value) { write(value); }
+
+private:
+    ofstream file;
+
+    template <typename T>
+    void write(const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void text(const string& value) {
+        size_t length = value.size();
+        write(length);
+        file.write(value.data(), length);
+    }
+};
+
+struct FeedLine {
+    uint64_t sequence;
+    string type;
+};
+
+vector<FeedLine> parseFeed(const string& feed) {
+    vector<FeedLine> lines;
+    stringstream in(feed);
+    string line;
+    while (getline(in, line)) {
+        FeedLine parsed;
+        parsed.sequence = stoull(line.substr(line.find(':') + 1));
+        size_t type = line.find("\"type\":\"") + 8;
+        parsed.type = line.substr(type, line.find('"', type) - type);
+        lines.push_back(parsed);
+    }
+    return lines;
+}
+
+vector<FeedLine> exportFeed(RFIDSystem& system, uint64_t since, uint64_t& next) {
+    stringstream out;
+    next = system.exportChanges(since, out);
+    return parseFeed(out.str());
+}
+
+uint32_t fileVersion(const string& dir) {
+    uint32_t version = 0;
+    ifstream file((dir + "/system_data.bin").c_str(), ios::binary);
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    return version;
+}
+
+// Version 1 files have no sequence numbers: users are numbered from 1 in
+// file order and logs follow them. Saving writes version 2 with the same
+// numbers, and new changes continue from there.
+void testVersionOneRoundTrip() {
+    const string dir = "feed_v1";
+    removeData(dir);
+    createDirectories(dir);
+    {
+        DataFileWriter file(dir, 1);
+        file.count(2);
+        file.user("A1", "Ann", "student", "OUT");
+        file.user("B2", "Bo", "staff", "IN");
+        file.count(3);
+        file.log("A1", "Ann", "IN", 1704100000);
+        file.log("B2", "Bo", "IN", 1704100100);
+        file.log("A1", "Ann", "OUT", 1704100200);
+    }
+
+    uint64_t next = 0;
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        CHECK_EQUAL(5u, system.getLastSequence());
+        vector<FeedLine> feed = exportFeed(system, 0, next);
+        CHECK_EQUAL(5u, next);
+        CHECK_EQUAL(5u, feed.size());
+        for (size_t i = 0; i < feed.size(); ++i) {
+            CHECK_EQUAL(i + 1, feed[i].sequence);
+            CHECK_EQUAL(string(i < 2 ? "user" : "scan"), feed[i].type);
+        }
+        CHECK(system.saveSystemData());
+    }
+    CHECK_EQUAL(2u, fileVersion(dir));
+
+    {
+        RFIDSystem system(dir);
+        CHECK_EQUAL(5u, system.getLastSequence());
+        SystemSnapshot snap = system.snapshot();
+        CHECK_EQUAL(2u, snap.getUsers()[1].sequence);
+        CHECK_EQUAL(3u, snap.getLogSequence(0));
+        CHECK_EQUAL(5u, snap.getLogSequence(2));
+        CHECK_EQUAL(string("IN"), snap.getStatus("B2"));
+
+        CHECK(system.scanRFID("B2"));
+        vector<FeedLine> feed = exportFeed(system, 5, next);
+        CHECK_EQUAL(1u, feed.size());
+        CHECK_EQUAL(6u, next);
+    }
+    removeData(dir);
+}
+
+// A consumer at sequence N gets exactly the users and scans after N, in
+// order, without a reset.
+void testDeltaAfterSequence() {
+    const string dir = "feed_delta";
+    removeData(dir);
+    RFIDSystem system(dir, StartupMode::EAGER);
+    system.addUser("A1", "Ann", "student"); // 1
+    system.addUser("B2", "Bo", "staff");    // 2
+    system.scanRFID("A1");                  // 3
+    system.scanRFID("B2");                  // 4
+    system.addUser("C3", "Cy", "faculty");  // 5
+    system.scanRFID("A1");                  // 6
+
+    uint64_t next = 0;
+    vector<FeedLine> feed = exportFeed(system, 4, next);
+    CHECK_EQUAL(6u, next);
+    CHECK_EQUAL(2u, feed.size());
+    if (feed.size() == 2) {
+        CHECK_EQUAL(5u, feed[0].sequence);
+        CHECK_EQUAL(string("user"), feed[0].type);
+        CHECK_EQUAL(6u, feed[1].sequence);
+        CHECK_EQUAL(string("scan"), feed[1].type);
+    }
+
+    feed = exportFeed(system, 6, next);
+    CHECK(feed.empty());
+    CHECK_EQUAL(6u, next);
+
+    // a cursor from the future cannot be continued
+    feed = exportFeed(system, 99, next);
+    CHECK(!feed.empty() && feed[0].type == "reset");
+    system.waitForSaves();
+    removeData(dir);
+}
+
+// Clearing the logs removes changes a consumer may already have seen, so a
+// cursor from before the clear gets a reset and the full state; one taken
+// at the reset sequence continues normally.
+void testResetAfterClear() {
+    const string dir = "feed_reset";
+    removeData(dir);
+    RFIDSystem system(dir, StartupMode::EAGER);
+    system.addUser("A1", "Ann", "student");
+    system.addUser("B2", "Bo", "staff");
+    system.scanRFID("A1");
+    uint64_t cursor = system.getLastSequence();
+
+    system.clearDailyLogs();
+    uint64_t reset = system.snapshot().getResetSequence();
+    CHECK(reset > cursor);
+    system.scanRFID("B2");
+
+    uint64_t next = 0;
+    vector<FeedLine> feed = exportFeed(system, cursor, next);
+    CHECK_EQUAL(3u, feed.size()); // reset line and both users
+    if (!feed.empty()) {
+        CHECK_EQUAL(string("reset"), feed[0].type);
+        CHECK_EQUAL(next, feed[0].sequence);
+    }
+
+    feed = exportFeed(system, reset, next);
+    CHECK_EQUAL(1u, feed.size());
+    if (!feed.empty()) {
+        CHECK_EQUAL(string("scan"), feed[0].type);
+        CHECK_EQUAL(next, feed[0].sequence);
+    }
+    system.waitForSaves();
+    removeData(dir);
+}
+
+void writeOrderedUsers(DataFileWriter& file, uint64_t first, uint64_t second) {
+    file.count(2);
+    file.user("A1", "Ann", "student", "OUT");
+    file.sequence(first);
+    file.user("B2", "Bo", "staff", "OUT");
+    file.sequence(second);
+}
+
+void writeLogs(DataFileWriter& file, uint64_t first, uint64_t second) {
+    file.count(2);
+    file.log("A1", "Ann", "IN", 1704100000);
+    file.sequence(first);
+    file.log("A1", "Ann", "OUT", 1704100100);
+    file.sequence(second);
+}
+
+// Version 2 sequences must keep growing within the users and within the
+// logs; a file that breaks that is rejected rather than feeding consumers
+// changes out of order.
+void testSequenceOrdering() {
+    const string dir = "feed_order";
+
+    removeData(dir);
+    createDirectories(dir);
+    {
+        DataFileWriter file(dir, 2);
+        file.header(4, 0);
+        writeOrderedUsers(file, 2, 1);
+        writeLogs(file, 3, 4);
+    }
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        CHECK_EQUAL(0, system.getTotalUsers());
+    }
+
+    removeData(dir);
+    createDirectories(dir);
+    {
+        DataFileWriter file(dir, 2);
+        file.header(4, 0);
+        writeOrderedUsers(file, 1, 2);
+        writeLogs(file, 4, 4);
+    }
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        CHECK_EQUAL(0, system.getTotalUsers());
+        CHECK_EQUAL(0, system.getTotalScans());
+    }
+    {
+        // the users load at once; the bad history is dropped when it arrives
+        RFIDSystem system(dir, StartupMode::LAZY_HISTORY);
+        system.waitForHistory();
+        CHECK_EQUAL(2, system.getTotalUsers());
+        CHECK_EQUAL(0, system.getTotalScans());
+    }
+
+    removeData(dir);
+    createDirectories(dir);
+    {
+        DataFileWriter file(dir, 2);
+        file.header(4, 0);
+        writeOrderedUsers(file, 1, 2);
+        writeLogs(file, 3, 4);
+    }
+    {
+        RFIDSystem system(dir, StartupMode::EAGER);
+        CHECK_EQUAL(2, system.getTotalUsers());
+        CHECK_EQUAL(2, system.getTotalScans());
+        CHECK_EQUAL(4u, system.getLastSequence());
+    }
+    removeData(dir);
+}
+
+// Scans taken while the history is still loading are spliced in after the
+// stored logs with the sequence numbers they got, and no reader ever sees a
+// half-spliced epoch. The history ends a few logs short of a full segment,
+// so the splice has to add one.
+void testScansDuringLazyLoad() {
+    const string dir = "feed_lazy";
+    const size_t USERS = 10;
+    const size_t STORED = 49 * LogSegment::CAPACITY - 5;
+    const size_t SCANS = 2000;
+
+    removeData(dir);
+    createDirectories(dir);
+    vector<bool> inside(USERS, false);
+    {
+        DataFileWriter file(dir, 2);
+        file.header(USERS + STORED, 0);
+        file.count(USERS);
+        for (size_t i = 0; i < USERS; ++i) {
+            // the stored status is what the logs below leave behind
+            inside[i] = (STORED - 1 - i) / USERS % 2 == 0;
+            file.user("U" + to_string(i), "User", "student", inside[i] ? "IN" : "OUT");
+            file.sequence(i + 1);
+        }
+        file.count(STORED);
+        for (size_t i = 0; i < STORED; ++i) {
+            file.log("U" + to_string(i % USERS), "User", i / USERS % 2 == 0 ? "IN" : "OUT", 1704100000 + i);
+            file.sequence(USERS + 1 + i);
+        }
+    }
+
+    RFIDSystem system(dir, StartupMode::LAZY_HISTORY);
+    atomic<bool> done(false);
+    atomic<bool> overcounted(false);
+    thread reader([&] {
+        while (!done.load()) {
+            if (system.getTotalScans() > static_cast<int>(STORED + SCANS)) {
+                overcounted = true;
+            }
+        }
+    });
+    for (size_t i = 0; i < SCANS; ++i) {
+        size_t user = i * 3 % USERS;
+        CHECK(system.scanRFID("U" + to_string(user)));
+        inside[user] = !inside[user];
+    }
+    system.waitForHistory();
+    done = true;
+    reader.join();
+    CHECK(!overcounted.load());
+
+    SystemSnapshot snap = system.snapshot();
+    CHECK_EQUAL(STORED + SCANS, snap.getLogCount());
+    CHECK_EQUAL(static_cast<int>(STORED + SCANS), system.getTotalScans());
+    for (size_t i = 0; i < snap.getLogCount(); ++i) {
+        if (snap.getLogSequence(i) != USERS + 1 + i) {
+            CHECK_EQUAL(USERS + 1 + i, snap.getLogSequence(i));
+            break;
+        }
+    }
+    for (size_t i = 0; i < SCANS; ++i) {
+        CHECK(snap.getLog(STORED + i).userId() == "U" + to_string(i * 3 % USERS));
+    }
+    for (size_t i = 0; i < USERS; ++i) {
+        CHECK_EQUAL(string(inside[i] ? "IN" : "OUT"), snap.getStatus("U" + to_string(i)));
+    }
+    system.waitForSaves();
+    removeData(dir);
+}
+
+}
+
+int main() {
+    Logger::instance().setMinLevel(LogLevel::ERROR);
+    testVersionOneRoundTrip();
+    testDeltaAfterSequence();
+    testResetAfterClear();
+    testSequenceOrdering();
+    testScansDuringLazyLoad();
+    return testResult("ChangeFeedTest");
+}
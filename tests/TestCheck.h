@@ -0,0 +1,53 @@
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+// Minimal checks for the ctest executables: a failed CHECK reports the
+// expression and keeps going, and main returns testResult().
+static int testFailures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                      << "\n";                                                        \
+            ++testFailures;                                                           \
+        }                                                                             \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual)                                                     \
+    do {                                                                                  \
+        if (!((expected) == (actual))) {                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQUAL failed: " #actual \
+                      << " is " << (actual) << ", expected " << (expected) << "\n";       \
+            ++testFailures;                                                               \
+        }                                                                                 \
+    } while (0)
+
+// Removes a data directory left by a test, with every file a system may
+// have written into it.
+inline void removeData(const std::string& dir) {
+    const char* files[] = {
+        "system_data.bin", "system_data.bin.tmp", "system_data.json", "snapshot.jsonl",
+        "snapshot.jsonl.tmp", "alerts.log", "metrics.prom", "metrics.prom.tmp", "access_policy.conf"
+    };
+    for (const char* file : files) {
+        std::remove((dir + "/" + file).c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+inline int testResult(const char* name) {
+    if (testFailures > 0) {
+        std::cerr << name << ": " << testFailures << " checks failed\n";
+        return 1;
+    }
+    std::cout << name << ": all checks passed\n";
+    return 0;
+}
+
+#endif